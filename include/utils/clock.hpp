@@ -0,0 +1,329 @@
+/**
+ * @file clock.hpp
+ * @author stroll (116356647@qq.com)
+ * @brief 时钟源
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define STROLL_HAS_TSC 1
+#else
+#define STROLL_HAS_TSC 0
+#endif
+
+namespace stroll {
+
+/// @brief 时钟源接口，时间单位为ns
+///
+/// 非虚拟时钟的时间轴必须与 steady_clock(CLOCK_MONOTONIC) 一致，
+/// 定时器线程会直接用它的值去 wait_until。
+class ClockSource {
+   public:
+    virtual ~ClockSource() = default;
+
+    /// @brief 当前时间点，单位为ns
+    virtual uint64_t now_ns() = 0;
+
+    /// @brief 是否为虚拟时钟，虚拟时钟的时间只随 advance 推进，与真实时间无关
+    virtual bool is_virtual() const { return false; }
+
+    /// @brief 时钟精度，单位为ns
+    virtual uint64_t resolution_ns() const { return 1; }
+};
+
+/// @brief 默认时钟，直接读取 steady_clock
+class SteadyClock final : public ClockSource {
+   public:
+    static SteadyClock &instance() {
+        static SteadyClock _inst;
+        return _inst;
+    }
+
+    uint64_t now_ns() override { return read(); }
+
+    static uint64_t read() { return std::chrono::steady_clock::now().time_since_epoch().count(); }
+};
+
+/// @brief 粗粒度时钟，读取 CLOCK_MONOTONIC_COARSE
+///
+/// 与 CLOCK_MONOTONIC 同一时间轴，精度为一个 jiffy(通常1~10ms)，
+/// 读取只访问 vDSO 中缓存的值，比精确时钟快得多，适合低精度定时器。
+class CoarseClock final : public ClockSource {
+   public:
+    static CoarseClock &instance() {
+        static CoarseClock _inst;
+        return _inst;
+    }
+
+    uint64_t now_ns() override { return read(); }
+
+    uint64_t resolution_ns() const override { return resolution_; }
+
+    static uint64_t read() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return ts.tv_sec * 1000ull * 1000 * 1000 + ts.tv_nsec;
+    }
+
+   private:
+    CoarseClock() {
+        struct timespec ts;
+        clock_getres(CLOCK_MONOTONIC_COARSE, &ts);
+        resolution_ = ts.tv_sec * 1000ull * 1000 * 1000 + ts.tv_nsec;
+    }
+
+   private:
+    uint64_t resolution_ = 1;
+};
+
+/// @brief 虚拟时钟，用于仿真和回放，时间只能手动推进
+///
+/// 推进时会调用 wakeup 回调，使用该时钟的定时器管理器借此重新检查到期任务。
+class VirtualClock final : public ClockSource {
+   public:
+    using WakeupFunc = std::function<void()>;
+
+    explicit VirtualClock(uint64_t start_ns = 0) : now_(start_ns) {}
+
+    uint64_t now_ns() override { return now_.load(std::memory_order_acquire); }
+
+    bool is_virtual() const override { return true; }
+
+    /// @brief 时间向前推进 ns
+    void advance(uint64_t ns) { advance_to(now_ns() + ns); }
+
+    /// @brief 时间推进到 tp，早于当前时间则忽略
+    void advance_to(uint64_t tp) {
+        auto cur = now_.load(std::memory_order_relaxed);
+        while (tp > cur && !now_.compare_exchange_weak(cur, tp, std::memory_order_acq_rel)) {
+        }
+
+        std::lock_guard guard(mtx_);
+        if (wakeup_) {
+            wakeup_();
+        }
+    }
+
+    /// @brief 设置时间推进时的通知回调
+    void set_wakeup(const WakeupFunc &func) {
+        std::lock_guard guard(mtx_);
+        wakeup_ = func;
+    }
+
+   private:
+    std::atomic<uint64_t> now_;
+    std::mutex mtx_;
+    WakeupFunc wakeup_;
+};
+
+/// @brief 基于 invariant TSC 的快速时钟
+///
+/// 启动时对照 CLOCK_MONOTONIC 标定 TSC 频率，之后读时间只需要一条 rdtsc 和一次乘法。
+/// 每隔 resync 周期由碰到的读者重新对齐一次，修正频率误差带来的漂移，
+/// 对齐时保持时间连续不回退。参数用 seqlock 保护，读路径无锁。
+/// TSC 不是 invariant 时退化为读取 steady_clock，一般通过 fast_clock() 选择。
+class TscClock final : public ClockSource {
+    static const unsigned kShift = 32;
+    static constexpr uint64_t kCalibrateNs = 10ull * 1000 * 1000;
+    static constexpr uint64_t kResyncNs = 1000ull * 1000 * 1000;
+
+   public:
+    static TscClock &instance() {
+        static TscClock _inst;
+        return _inst;
+    }
+
+    /// @brief CPU 是否提供 invariant TSC
+    static bool supported() {
+#if STROLL_HAS_TSC
+        unsigned eax, ebx, ecx, edx;
+        if (!__get_cpuid(0x80000000u, &eax, &ebx, &ecx, &edx) || eax < 0x80000007u) {
+            return false;
+        }
+        __get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx);
+        return (edx & (1u << 8)) != 0;
+#else
+        return false;
+#endif
+    }
+
+    uint64_t now_ns() override {
+        if (!enabled_) {
+            return SteadyClock::read();
+        }
+
+        uint64_t tsc;
+        uint64_t ns;
+        bool expired;
+        uint32_t seq;
+        do {
+            seq = seq_.load(std::memory_order_acquire);
+            tsc = read_tsc();
+            auto base_tsc = base_tsc_.load(std::memory_order_relaxed);
+            auto delta = tsc > base_tsc ? tsc - base_tsc : 0;
+            ns = base_ns_.load(std::memory_order_relaxed) +
+                 scale(delta, mult_.load(std::memory_order_relaxed));
+            expired = delta > resync_ticks_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((seq & 1) || seq != seq_.load(std::memory_order_relaxed));
+
+        if (expired) {
+            resync(seq);
+        }
+        return ns;
+    }
+
+    /// @brief 是否真正在使用 TSC
+    bool enabled() const { return enabled_; }
+
+    /// @brief 只读取 TSC，不换算也不触发重新对齐，配合 to_ns 在热路径上记录时间
+    static uint64_t ticks() { return read_tsc(); }
+
+    /// @brief 把不久前 ticks 读到的值按当前参数换算为单调时间，单位为ns，同样负责定期重新对齐
+    uint64_t to_ns(uint64_t tsc) {
+        uint64_t ns;
+        bool expired;
+        uint32_t seq;
+        do {
+            seq = seq_.load(std::memory_order_acquire);
+            auto base_tsc = base_tsc_.load(std::memory_order_relaxed);
+            auto base_ns = base_ns_.load(std::memory_order_relaxed);
+            auto mult = mult_.load(std::memory_order_relaxed);
+            ns = tsc >= base_tsc ? base_ns + scale(tsc - base_tsc, mult)
+                                 : base_ns - std::min(base_ns, scale(base_tsc - tsc, mult));
+            expired = tsc > base_tsc &&
+                      tsc - base_tsc > resync_ticks_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((seq & 1) || seq != seq_.load(std::memory_order_relaxed));
+
+        if (expired) {
+            resync(seq);
+        }
+        return ns;
+    }
+
+   private:
+    TscClock() : enabled_(supported()) {
+        if (!enabled_) {
+            return;
+        }
+
+        sample(first_tsc_, first_ns_);
+        std::this_thread::sleep_for(std::chrono::nanoseconds(kCalibrateNs));
+        uint64_t tsc = 0, ns = 0;
+        sample(tsc, ns);
+
+        auto mult = ratio(ns - first_ns_, tsc - first_tsc_);
+        base_tsc_ = tsc;
+        base_ns_ = ns;
+        mult_ = mult;
+        resync_ticks_ = ratio(kResyncNs, mult);
+    }
+
+    static uint64_t read_tsc() {
+#if STROLL_HAS_TSC
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    static uint64_t read_monotonic() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000ull * 1000 * 1000 + ts.tv_nsec;
+    }
+
+    static uint64_t scale(uint64_t ticks, uint64_t mult) {
+        return (uint64_t)(((unsigned __int128)ticks * mult) >> kShift);
+    }
+
+    /// @brief 计算 (a << kShift) / b，用来求 ns/tick 倍率或反求 tick 数
+    static uint64_t ratio(uint64_t a, uint64_t b) {
+        return (uint64_t)(((unsigned __int128)a << kShift) / b);
+    }
+
+    /// @brief 采样一对 (tsc, monotonic)，取读取窗口最小的一次，减小误差
+    static void sample(uint64_t &tsc, uint64_t &ns) {
+        uint64_t best = UINT64_MAX;
+        for (auto i = 0; i < 5; ++i) {
+            auto begin = read_tsc();
+            auto mono = read_monotonic();
+            auto end = read_tsc();
+            if (end - begin < best) {
+                best = end - begin;
+                tsc = begin + (end - begin) / 2;
+                ns = mono;
+            }
+        }
+    }
+
+    /// @brief 重新对齐 CLOCK_MONOTONIC，只有一个读者会真正执行
+    void resync(uint32_t seq) {
+        if (!seq_.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire)) {
+            return;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+
+        uint64_t tsc = 0, mono = 0;
+        sample(tsc, mono);
+
+        //< 长窗口下的平均频率
+        auto period_mult = ratio(mono - first_ns_, tsc - first_tsc_);
+        auto period_ticks = ratio(kResyncNs, period_mult);
+
+        //< 从当前值出发保持连续，斜率调整为一个周期后追上 CLOCK_MONOTONIC
+        auto cur = base_ns_.load(std::memory_order_relaxed) +
+                   scale(tsc - base_tsc_.load(std::memory_order_relaxed),
+                         mult_.load(std::memory_order_relaxed));
+        auto target = mono + kResyncNs;
+        auto mult = target > cur ? ratio(target - cur, period_ticks) : 0;
+        //< 修正幅度限制在 ±1/8，避免时间停滞或突变
+        mult = std::min(std::max(mult, period_mult - period_mult / 8), period_mult + period_mult / 8);
+
+        base_tsc_.store(tsc, std::memory_order_relaxed);
+        base_ns_.store(cur, std::memory_order_relaxed);
+        mult_.store(mult, std::memory_order_relaxed);
+        resync_ticks_.store(period_ticks, std::memory_order_relaxed);
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+   private:
+    const bool enabled_;
+    uint64_t first_tsc_ = 0;
+    uint64_t first_ns_ = 0;
+
+    std::atomic<uint32_t> seq_{0};
+    std::atomic<uint64_t> base_tsc_{0};
+    std::atomic<uint64_t> base_ns_{0};
+    std::atomic<uint64_t> mult_{0};
+    std::atomic<uint64_t> resync_ticks_{UINT64_MAX};
+};
+
+/// @brief 获取最快的可用时钟：支持 invariant TSC 时为 TscClock，否则为 SteadyClock
+static inline ClockSource &fast_clock() {
+    if (TscClock::supported()) {
+        return TscClock::instance();
+    }
+    return SteadyClock::instance();
+}
+
+}  // namespace stroll
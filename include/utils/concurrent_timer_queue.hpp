@@ -0,0 +1,393 @@
+/**
+ * @file concurrent_timer_queue.hpp
+ * @author stroll (116356647@qq.com)
+ * @brief 无锁跳表定时器队列，多线程并发启动，单个检查线程取出到期任务
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include "utils/timer.hpp"
+
+namespace stroll {
+
+/// @brief 基于 epoch 的内存回收域，所有 ConcurrentTimerQueue 共用
+///
+/// 生产者在访问跳表期间登记当前 epoch，检查线程摘除的节点至少等 epoch 前进两次、
+/// 所有生产者都离开旧 epoch 之后才释放。
+class EpochDomain {
+    static const unsigned kMaxThreads = 256;
+    static const uint64_t kIdle = UINT64_MAX;
+
+   public:
+    static EpochDomain &instance() {
+        static EpochDomain _inst;
+        return _inst;
+    }
+
+    /// @brief 生产者访问区间
+    class Guard {
+       public:
+        Guard() : slot_(EpochDomain::instance().local_slot()) {
+            auto &domain = EpochDomain::instance();
+            //< 登记后重新确认，避免登记的是已经过期的 epoch
+            auto epoch = domain.global_.load();
+            while (true) {
+                slot_.store(epoch);
+                auto cur = domain.global_.load();
+                if (cur == epoch) {
+                    break;
+                }
+                epoch = cur;
+            }
+        }
+
+        ~Guard() { slot_.store(kIdle, std::memory_order_release); }
+
+       private:
+        std::atomic<uint64_t> &slot_;
+    };
+
+    uint64_t epoch() const { return global_.load(); }
+
+    /// @brief 所有活跃线程都已进入当前 epoch 时推进一次
+    uint64_t try_advance() {
+        auto epoch = global_.load();
+        auto used = used_.load(std::memory_order_acquire);
+        for (auto i = 0u; i < used; ++i) {
+            auto local = slots_[i].epoch.load();
+            if (local != kIdle && local != epoch) {
+                return epoch;
+            }
+        }
+        global_.compare_exchange_strong(epoch, epoch + 1);
+        return global_.load();
+    }
+
+   private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch{kIdle};
+        std::atomic<bool> owned{false};
+    };
+
+    /// @brief 线程退出时归还槽位
+    struct SlotOwner {
+        Slot *slot = nullptr;
+        ~SlotOwner() {
+            if (slot) {
+                slot->epoch.store(kIdle);
+                slot->owned.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    std::atomic<uint64_t> &local_slot() {
+        thread_local SlotOwner owner;
+        if (!owner.slot) {
+            owner.slot = acquire_slot();
+        }
+        return owner.slot->epoch;
+    }
+
+    Slot *acquire_slot() {
+        while (true) {
+            for (auto i = 0u; i < kMaxThreads; ++i) {
+                bool expected = false;
+                if (!slots_[i].owned.load() &&
+                    slots_[i].owned.compare_exchange_strong(expected, true)) {
+                    auto used = used_.load();
+                    while (used < i + 1 && !used_.compare_exchange_weak(used, i + 1)) {
+                    }
+                    return &slots_[i];
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+   private:
+    std::atomic<uint64_t> global_{0};
+    std::atomic<unsigned> used_{0};
+    Slot slots_[kMaxThreads];
+};
+
+/// @brief 无锁跳表定时器队列
+///
+/// 任意线程可以并发 insert/cancel，互相之间以及与检查线程之间都不阻塞；
+/// delete_min 只能由单个检查线程调用。节点按 (到期时间, 序号) 排序，
+/// 删除时先自顶向下标记各层 next 指针，再由查找过程摘除，做法同 Herlihy-Shavit 无锁跳表。
+/// 取消只递增定时器的代数 O(1)，过期的条目在到达队首时丢弃。
+///
+/// 作为 BasicTimerManager 的 Heap 参数时，start/stop/set_interval 不再经过堆锁，
+/// 堆锁只用来保证同一时刻只有一个检查线程；不支持定时器组，周期任务也不使用同周期队列。
+class ConcurrentTimerQueue {
+    static const int kMaxLevel = 20;
+
+    struct Entry {
+        uint64_t tp = 0;
+        uint64_t seq;
+        uint32_t gen = 0;
+        int level;
+        TimerHandler handler;
+        std::atomic<bool> linked{false};  //< 插入过程已结束，之后不会再被链接到上层
+        std::atomic<uintptr_t> next[kMaxLevel];
+
+        Entry(uint64_t t, uint64_t s, int l) : tp(t), seq(s), gen(0), level(l) {
+            for (auto &n : next) {
+                n.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        bool less(uint64_t t, uint64_t s) const { return tp < t || (tp == t && seq < s); }
+    };
+
+   public:
+    static constexpr bool kConcurrent = true;
+
+    ConcurrentTimerQueue() : head_(0, 0, kMaxLevel) {}
+
+    ~ConcurrentTimerQueue() {
+        auto node = ptr(head_.next[0].load());
+        while (node) {
+            auto next = ptr(node->next[0].load());
+            delete node;
+            node = next;
+        }
+        for (auto &item : retired_) {
+            delete item.second;
+        }
+        for (auto entry : limbo_) {
+            delete entry;
+        }
+    }
+
+    ConcurrentTimerQueue(const ConcurrentTimerQueue &) = delete;
+    ConcurrentTimerQueue &operator=(const ConcurrentTimerQueue &) = delete;
+
+    /// @brief 在 tp 启动定时器，之前的启动自动失效，可并发调用
+    /// @return 新条目成为队首时返回 true，调用者可以据此唤醒检查线程
+    bool insert(const TimerHandler &handler, uint64_t tp) {
+        return insert_entry(handler, tp, 0, false) > 0;
+    }
+
+    /// @brief 只在定时器的代数仍为 gen 时在 tp 启动，期间被 insert/cancel 过则放弃
+    /// @return 代数已变化、没有插入时返回 false
+    bool insert_if(const TimerHandler &handler, uint64_t tp, uint32_t gen) {
+        return insert_entry(handler, tp, gen, true) >= 0;
+    }
+
+    /// @brief 取消定时器，O(1)，可并发调用
+    void cancel(const TimerHandler &handler) {
+        handler->queue_gen.fetch_add(1);
+    }
+
+    /// @brief 最近的到期时间，可能属于已取消的条目，只能在检查线程调用
+    uint64_t next_deadline() {
+        auto first = ptr(head_.next[0].load());
+        return first ? first->tp : TimerNode::kMaxTimePoint;
+    }
+
+    /// @brief 取出一个在 now 之前到期的有效定时器，只能在检查线程调用
+    /// @param tp 返回条目的到期时间
+    /// @param gen 返回条目的代数，取出后定时器的代数不变时可以用 insert_if 重新启动
+    /// @return 没有到期任务时返回空
+    TimerHandler delete_min(uint64_t now, uint64_t &tp, uint32_t &gen) {
+        TimerHandler result;
+        while (!result) {
+            auto first = ptr(head_.next[0].load());
+            if (!first || first->tp > now) {
+                break;
+            }
+
+            remove(first);
+            if (first->gen == first->handler->queue_gen.load()) {
+                result = first->handler;
+                tp = first->tp;
+                gen = first->gen;
+            }
+            retire(first);
+        }
+        reclaim();
+        return result;
+    }
+
+    TimerHandler delete_min(uint64_t now) {
+        uint64_t tp = 0;
+        uint32_t gen = 0;
+        return delete_min(now, tp, gen);
+    }
+
+    /// @brief 已摘除但还未释放的条目数，只能在检查线程调用
+    size_t retired() const { return retired_.size() + limbo_.size(); }
+
+    void dump() { printf("concurrent timer queue, next deadline: %" PRIu64 "\n", next_deadline()); }
+
+   private:
+    /// @return 没有插入返回 -1，成为队首返回 1，否则返回 0
+    int insert_entry(const TimerHandler &handler, uint64_t tp, uint32_t gen, bool conditional) {
+        EpochDomain::Guard guard;
+
+        //< 先占用新的代数，之前的条目随之失效
+        auto next_gen = gen + 1;
+        if (conditional) {
+            if (!handler->queue_gen.compare_exchange_strong(gen, next_gen)) {
+                return -1;
+            }
+        } else {
+            next_gen = handler->queue_gen.fetch_add(1) + 1;
+        }
+        auto entry = new Entry(tp, seq_.fetch_add(1, std::memory_order_relaxed), random_level());
+        entry->handler = handler;
+        entry->gen = next_gen;
+
+        Entry *preds[kMaxLevel];
+        Entry *succs[kMaxLevel];
+        while (true) {
+            find(tp, entry->seq, preds, succs);
+            for (auto i = 0; i < entry->level; ++i) {
+                entry->next[i].store(reinterpret_cast<uintptr_t>(succs[i]),
+                                     std::memory_order_relaxed);
+            }
+            auto expected = reinterpret_cast<uintptr_t>(succs[0]);
+            if (preds[0]->next[0].compare_exchange_strong(expected,
+                                                          reinterpret_cast<uintptr_t>(entry))) {
+                break;
+            }
+        }
+        auto is_first = preds[0] == &head_;
+
+        //< 逐层链接上层，条目已被删除时停止
+        for (auto i = 1; i < entry->level; ++i) {
+            while (true) {
+                auto next = entry->next[i].load();
+                if (marked(next)) {
+                    break;
+                }
+                if (ptr(next) != succs[i] &&
+                    !entry->next[i].compare_exchange_strong(next,
+                                                            reinterpret_cast<uintptr_t>(succs[i]))) {
+                    break;
+                }
+                auto expected = reinterpret_cast<uintptr_t>(succs[i]);
+                if (preds[i]->next[i].compare_exchange_strong(expected,
+                                                              reinterpret_cast<uintptr_t>(entry))) {
+                    break;
+                }
+                find(tp, entry->seq, preds, succs);
+            }
+        }
+
+        //< 链接期间已被检查线程删除，摘除可能晚于删除链接上的上层指针
+        if (marked(entry->next[0].load())) {
+            find(tp, entry->seq, preds, succs);
+        }
+        entry->linked.store(true, std::memory_order_release);
+        return is_first;
+    }
+
+    static bool marked(uintptr_t p) { return p & 1; }
+
+    static Entry *ptr(uintptr_t p) { return reinterpret_cast<Entry *>(p & ~uintptr_t(1)); }
+
+    static int random_level() {
+        thread_local uint64_t state = reinterpret_cast<uintptr_t>(&state) | 1;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        auto level = 1 + __builtin_ctzll(state | (1ull << (kMaxLevel - 1)));
+        return level;
+    }
+
+    /// @brief 查找每层中 (tp, seq) 的前驱和后继，顺带摘除已标记删除的条目
+    void find(uint64_t tp, uint64_t seq, Entry **preds, Entry **succs) {
+    retry:
+        auto pred = &head_;
+        for (auto i = kMaxLevel - 1; i >= 0; --i) {
+            auto curr = ptr(pred->next[i].load());
+            while (curr) {
+                auto succ = curr->next[i].load();
+                while (marked(succ)) {
+                    auto expected = reinterpret_cast<uintptr_t>(curr);
+                    if (!pred->next[i].compare_exchange_strong(expected,
+                                                               reinterpret_cast<uintptr_t>(ptr(succ)))) {
+                        goto retry;
+                    }
+                    curr = ptr(succ);
+                    if (!curr) {
+                        break;
+                    }
+                    succ = curr->next[i].load();
+                }
+                if (!curr || !curr->less(tp, seq)) {
+                    break;
+                }
+                pred = curr;
+                curr = ptr(succ);
+            }
+            preds[i] = pred;
+            succs[i] = curr;
+        }
+    }
+
+    /// @brief 自顶向下标记各层，第0层标记成功即完成逻辑删除，然后摘除
+    void remove(Entry *entry) {
+        for (auto i = entry->level - 1; i >= 0; --i) {
+            auto next = entry->next[i].load();
+            while (!marked(next) && !entry->next[i].compare_exchange_weak(next, next | 1)) {
+            }
+        }
+
+        Entry *preds[kMaxLevel];
+        Entry *succs[kMaxLevel];
+        find(entry->tp, entry->seq, preds, succs);
+    }
+
+    /// @brief 插入已结束的条目不会再被链接，可以交给 epoch 回收，否则先放入 limbo
+    void retire(Entry *entry) {
+        auto epoch = EpochDomain::instance().epoch();
+        if (entry->linked.load(std::memory_order_acquire)) {
+            retired_.emplace_back(epoch, entry);
+        } else {
+            limbo_.push_back(entry);
+        }
+    }
+
+    void reclaim() {
+        auto epoch = EpochDomain::instance().try_advance();
+        for (auto it = limbo_.begin(); it != limbo_.end();) {
+            if ((*it)->linked.load(std::memory_order_acquire)) {
+                retired_.emplace_back(epoch, *it);
+                it = limbo_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        size_t count = 0;
+        while (count < retired_.size() && retired_[count].first + 2 <= epoch) {
+            delete retired_[count].second;
+            ++count;
+        }
+        retired_.erase(retired_.begin(), retired_.begin() + count);
+    }
+
+   private:
+    Entry head_;
+    std::atomic<uint64_t> seq_{0};
+    //< 以下只由检查线程访问
+    std::vector<std::pair<uint64_t, Entry *>> retired_;
+    std::vector<Entry *> limbo_;
+};
+
+}  // namespace stroll
@@ -0,0 +1,58 @@
+/**
+ * @file futex.hpp
+ * @author stroll (116356647@qq.com)
+ * @brief 基于 futex 的轻量等待/唤醒
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace stroll {
+
+/// @brief 当 word 仍等于 expected 时阻塞，可能被虚假唤醒，调用者需要循环检查
+static inline void futex_wait(std::atomic<uint32_t> &word, uint32_t expected) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr,
+            nullptr, 0);
+#else
+    if (word.load(std::memory_order_acquire) == expected) {
+        std::this_thread::yield();
+    }
+#endif
+}
+
+/// @brief 唤醒最多 count 个等待在 word 上的线程
+static inline void futex_wake(std::atomic<uint32_t> &word, int count = INT32_MAX) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE_PRIVATE, count, nullptr,
+            nullptr, 0);
+#else
+    (void)word;
+    (void)count;
+#endif
+}
+
+/// @brief 自旋等待时的 CPU 提示，降低功耗并让出超线程资源
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+}  // namespace stroll
@@ -0,0 +1,471 @@
+/**
+ * @file log_format.hpp
+ * @author stroll (116356647@qq.com)
+ * @brief fmt 风格的日志格式串：编译期解析和类型检查，运行时按参数类型直接格式化，不经过 printf
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace stroll {
+
+/// @brief 格式串错误，在常量求值中被调用即编译失败，错误原因见调用处的参数
+inline void log_format_error(const char *) {}
+
+/// @brief 浮点数的最大精度，小数部分按 uint64_t 换算，更高的精度在编译期报错
+static constexpr int kLogFmtMaxPrecision = 9;
+
+/// @brief 格式串的一段：原样输出的文字或一个 {} 字段
+///
+/// 字段语法为 {[:[[fill]align][0][width][.precision][type]]}，align 为 < > ^，
+/// type 为 d x X o b c s f e p，不支持位置参数。浮点数精度最多 kLogFmtMaxPrecision 位，
+/// 绝对值不小于 1e18 时即使指定 f 也按科学计数法输出。
+struct LogFmtPiece {
+    bool field = false;
+    uint16_t begin = 0;  //< 文字在格式串中的起始位置
+    uint16_t len = 0;
+    char type = 0;
+    char fill = ' ';
+    char align = 0;
+    bool zero = false;  //< 数值在符号之后补0
+    uint16_t width = 0;
+    int16_t precision = -1;
+};
+
+/// @brief 编译期解析好的格式串
+struct LogFmtSpec {
+    static constexpr unsigned kMaxPieces = 32;
+
+    LogFmtPiece pieces[kMaxPieces] = {};
+    unsigned count = 0;
+    unsigned fields = 0;
+
+    static constexpr LogFmtSpec parse(const char *fmt) {
+        LogFmtSpec spec;
+        size_t begin = 0;
+        size_t i = 0;
+        while (fmt[i] != '\0') {
+            auto c = fmt[i];
+            if ((c == '{' || c == '}') && fmt[i + 1] == c) {
+                //< {{ 和 }} 输出一个括号
+                spec.add_text(begin, i + 1);
+                i += 2;
+                begin = i;
+                continue;
+            }
+            if (c == '}') {
+                log_format_error("unmatched '}' in format string");
+                return spec;
+            }
+            if (c != '{') {
+                ++i;
+                continue;
+            }
+
+            spec.add_text(begin, i);
+            LogFmtPiece field;
+            field.field = true;
+            ++i;
+            if (fmt[i] == ':') {
+                ++i;
+                parse_field(fmt, i, field);
+            }
+            if (fmt[i] != '}') {
+                log_format_error("invalid format field, expected {} or {:spec}");
+                return spec;
+            }
+            ++i;
+            begin = i;
+            spec.add(field);
+            ++spec.fields;
+        }
+        spec.add_text(begin, i);
+        return spec;
+    }
+
+   private:
+    constexpr void add(const LogFmtPiece &piece) {
+        if (count == kMaxPieces) {
+            log_format_error("too many fields in format string");
+            return;
+        }
+        pieces[count++] = piece;
+    }
+
+    constexpr void add_text(size_t begin, size_t end) {
+        if (end > begin) {
+            LogFmtPiece text;
+            text.begin = begin;
+            text.len = end - begin;
+            add(text);
+        }
+    }
+
+    static constexpr bool is_align(char c) { return c == '<' || c == '>' || c == '^'; }
+
+    static constexpr bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+    static constexpr void parse_field(const char *fmt, size_t &i, LogFmtPiece &field) {
+        if (fmt[i] != '\0' && fmt[i] != '}' && is_align(fmt[i + 1])) {
+            field.fill = fmt[i];
+            field.align = fmt[i + 1];
+            i += 2;
+        } else if (is_align(fmt[i])) {
+            field.align = fmt[i++];
+        }
+        if (fmt[i] == '0') {
+            field.zero = true;
+            ++i;
+        }
+        while (is_digit(fmt[i])) {
+            field.width = field.width * 10 + (fmt[i++] - '0');
+        }
+        if (fmt[i] == '.') {
+            ++i;
+            if (!is_digit(fmt[i])) {
+                log_format_error("missing precision after '.'");
+            }
+            field.precision = 0;
+            while (is_digit(fmt[i])) {
+                field.precision = field.precision * 10 + (fmt[i++] - '0');
+            }
+        }
+        if (fmt[i] != '\0' && fmt[i] != '}') {
+            field.type = fmt[i++];
+        }
+    }
+};
+
+/// @brief 参数的存储类型：字符数组和 char * 按 C 字符串，std::string 按 string_view
+template <typename T>
+using log_fmt_arg_t = std::conditional_t<
+    std::is_same_v<std::decay_t<T>, char *>, const char *,
+    std::conditional_t<std::is_same_v<std::decay_t<T>, std::string>, std::string_view,
+                       std::decay_t<T>>>;
+
+static constexpr bool log_fmt_has_type(char type, const char *allowed) {
+    for (; *allowed != '\0'; ++allowed) {
+        if (*allowed == type) {
+            return true;
+        }
+    }
+    return type == 0;
+}
+
+/// @brief 检查一个字段的类型说明是否适用于参数类型 T
+template <typename T>
+static constexpr bool log_fmt_check_arg(const LogFmtPiece &field) {
+    auto ok = true;
+    if constexpr (std::is_same_v<T, bool>) {
+        ok = log_fmt_has_type(field.type, "sd");
+    } else if constexpr (std::is_same_v<T, char>) {
+        ok = log_fmt_has_type(field.type, "cdxX");
+    } else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+        ok = log_fmt_has_type(field.type, "dxXobc");
+    } else if constexpr (std::is_floating_point_v<T>) {
+        ok = log_fmt_has_type(field.type, "fe");
+    } else if constexpr (std::is_same_v<T, const char *> || std::is_same_v<T, std::string_view>) {
+        ok = log_fmt_has_type(field.type, "s");
+    } else if constexpr (std::is_pointer_v<T>) {
+        ok = log_fmt_has_type(field.type, "px");
+    } else {
+        log_format_error("unsupported argument type");
+        return false;
+    }
+    if (!ok) {
+        log_format_error("format type does not match the argument type");
+    }
+    if (field.precision >= 0 && !std::is_floating_point_v<T> &&
+        !std::is_same_v<T, const char *> && !std::is_same_v<T, std::string_view>) {
+        log_format_error("precision is only allowed for floating point and string arguments");
+        ok = false;
+    }
+    if (std::is_floating_point_v<T> && field.precision > kLogFmtMaxPrecision) {
+        log_format_error("floating point precision must not exceed 9");
+        ok = false;
+    }
+    return ok;
+}
+
+/// @brief 编译期检查格式串与参数，参数以 std::forward_as_tuple 的类型给出
+template <typename Tuple>
+struct LogFmtChecker;
+
+template <typename... Ts>
+struct LogFmtChecker<std::tuple<Ts...>> {
+    static constexpr bool check(const LogFmtSpec &spec) {
+        if (spec.fields != sizeof...(Ts)) {
+            log_format_error("number of {} fields does not match the number of arguments");
+            return false;
+        }
+        unsigned piece = 0;
+        [[maybe_unused]] auto next = [&]() -> const LogFmtPiece & {
+            while (!spec.pieces[piece].field) {
+                ++piece;
+            }
+            return spec.pieces[piece++];
+        };
+        return (true && ... && log_fmt_check_arg<log_fmt_arg_t<Ts>>(next()));
+    }
+};
+
+/// @brief 定长输出缓冲，放不下时截断，needed 记录完整输出所需的长度
+class LogFmtBuffer {
+   public:
+    LogFmtBuffer(char *data, size_t capacity) : data_(data), capacity_(capacity) {}
+
+    void put(char c) {
+        if (size_ < capacity_) {
+            data_[size_++] = c;
+        }
+        ++needed_;
+    }
+
+    void put(const char *text, size_t len) {
+        auto n = std::min(len, capacity_ - size_);
+        memcpy(data_ + size_, text, n);
+        size_ += n;
+        needed_ += len;
+    }
+
+    void put(const char *text) { put(text, strlen(text)); }
+
+    size_t size() const { return size_; }
+    size_t needed() const { return needed_; }
+
+   private:
+    char *data_;
+    size_t capacity_;
+    size_t size_ = 0;
+    size_t needed_ = 0;
+};
+
+/// @brief 从 end 向前写入 value 的 base 进制表示，返回起始位置
+static inline char *log_fmt_uint(char *end, uint64_t value, unsigned base, bool upper = false) {
+    static constexpr char kPairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    if (base == 10) {
+        while (value >= 100) {
+            auto pair = value % 100 * 2;
+            value /= 100;
+            *--end = kPairs[pair + 1];
+            *--end = kPairs[pair];
+        }
+        if (value >= 10) {
+            *--end = kPairs[value * 2 + 1];
+            *--end = kPairs[value * 2];
+        } else {
+            *--end = '0' + value;
+        }
+        return end;
+    }
+    auto digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    do {
+        *--end = digits[value % base];
+        value /= base;
+    } while (value != 0);
+    return end;
+}
+
+/// @brief 按宽度和对齐输出一段文字，数值默认右对齐，0 标志在符号之后补0
+template <typename Out>
+static void log_fmt_text(Out &out, const LogFmtPiece &field, const char *text, size_t len,
+                         bool numeric) {
+    if (field.width <= len) {
+        out.put(text, len);
+        return;
+    }
+    auto pad = field.width - len;
+    if (numeric && field.zero && field.align == 0) {
+        if (len > 0 && (*text == '-' || *text == '+')) {
+            out.put(*text++);
+            --len;
+        }
+        while (pad-- > 0) {
+            out.put('0');
+        }
+        out.put(text, len);
+        return;
+    }
+
+    auto align = field.align ? field.align : (numeric ? '>' : '<');
+    auto left = align == '>' ? pad : align == '^' ? pad / 2 : 0;
+    for (auto i = 0u; i < left; ++i) {
+        out.put(field.fill);
+    }
+    out.put(text, len);
+    for (auto i = left; i < pad; ++i) {
+        out.put(field.fill);
+    }
+}
+
+/// @brief 浮点数转文字，默认去掉末尾的0，f 为定点，e 为科学计数法，精度最多9位
+///
+/// 逐位推导，不经过 printf，最后一位可能与 printf 的舍入不同。
+/// 整数部分要放进 uint64_t，绝对值不小于 1e18 时改用科学计数法。
+static inline size_t log_fmt_double(char *out, double value, char type, int precision) {
+    static constexpr uint64_t kPow10[] = {1,      10,      100,      1000,      10000,
+                                          100000, 1000000, 10000000, 100000000, 1000000000};
+    auto begin = out;
+    if (value != value) {
+        memcpy(out, "nan", 3);
+        return 3;
+    }
+    if (value < 0) {
+        *out++ = '-';
+        value = -value;
+    }
+    if (value > 1.7976931348623157e308) {
+        memcpy(out, "inf", 3);
+        return out + 3 - begin;
+    }
+
+    auto digits = std::min(precision < 0 ? 6 : precision, kLogFmtMaxPrecision);
+    auto exp = 0;
+    auto scientific = type == 'e' || value >= 1e18;
+    if (scientific && value != 0) {
+        while (value >= 10) {
+            value /= 10;
+            ++exp;
+        }
+        while (value < 1) {
+            value *= 10;
+            --exp;
+        }
+    }
+
+    auto integer = (uint64_t)value;
+    auto fraction = (uint64_t)((value - integer) * kPow10[digits] + 0.5);
+    if (fraction >= kPow10[digits]) {
+        fraction -= kPow10[digits];
+        ++integer;
+        if (scientific && integer == 10) {
+            integer = 1;
+            ++exp;
+        }
+    }
+
+    char text[24];
+    auto end = text + sizeof(text);
+    auto p = log_fmt_uint(end, integer, 10);
+    memcpy(out, p, end - p);
+    out += end - p;
+    if (digits > 0) {
+        *out++ = '.';
+        p = log_fmt_uint(end, fraction, 10);
+        for (auto i = end - p; i < digits; ++i) {
+            *out++ = '0';
+        }
+        memcpy(out, p, end - p);
+        out += end - p;
+        if (type == 0) {
+            while (out[-1] == '0') {
+                --out;
+            }
+            if (out[-1] == '.') {
+                --out;
+            }
+        }
+    }
+
+    if (scientific) {
+        *out++ = 'e';
+        *out++ = exp < 0 ? '-' : '+';
+        p = log_fmt_uint(end, exp < 0 ? -exp : exp, 10);
+        if (end - p < 2) {
+            *out++ = '0';
+        }
+        memcpy(out, p, end - p);
+        out += end - p;
+    }
+    return out - begin;
+}
+
+/// @brief 按字段说明输出一个参数
+template <typename Out, typename T>
+static void log_fmt_value(Out &out, const LogFmtPiece &field, const T &value) {
+    char text[72];
+    auto end = text + sizeof(text);
+    if constexpr (std::is_same_v<T, bool>) {
+        if (field.type == 'd') {
+            log_fmt_text(out, field, value ? "1" : "0", 1, true);
+        } else {
+            log_fmt_text(out, field, value ? "true" : "false", value ? 4 : 5, false);
+        }
+    } else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+        using Int = std::conditional_t<std::is_enum_v<T>, std::underlying_type<T>,
+                                       std::common_type<T>>;
+        auto number = (typename Int::type)value;
+        if (field.type == 'c' || (std::is_same_v<T, char> && field.type == 0)) {
+            auto c = (char)number;
+            log_fmt_text(out, field, &c, 1, false);
+            return;
+        }
+        auto base = field.type == 'x' || field.type == 'X' ? 16
+                    : field.type == 'o'                    ? 8
+                    : field.type == 'b'                    ? 2
+                                                           : 10;
+        auto negative = std::is_signed_v<decltype(number)> && number < 0;
+        auto magnitude = negative ? 0 - (uint64_t)number : (uint64_t)number;
+        auto p = log_fmt_uint(end, magnitude, base, field.type == 'X');
+        if (negative) {
+            *--p = '-';
+        }
+        log_fmt_text(out, field, p, end - p, true);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        log_fmt_text(out, field, text, log_fmt_double(text, value, field.type, field.precision),
+                     true);
+    } else if constexpr (std::is_same_v<T, const char *> || std::is_same_v<T, std::string_view>) {
+        std::string_view view;
+        if constexpr (std::is_same_v<T, std::string_view>) {
+            view = value;
+        } else {
+            view = value ? value : "(null)";
+        }
+        auto len = field.precision >= 0 ? std::min<size_t>(view.size(), field.precision)
+                                        : view.size();
+        log_fmt_text(out, field, view.data(), len, false);
+    } else {
+        auto p = log_fmt_uint(end, reinterpret_cast<uintptr_t>(value), 16);
+        *--p = 'x';
+        *--p = '0';
+        log_fmt_text(out, field, p, end - p, true);
+    }
+}
+
+/// @brief 按解析好的格式串输出全部参数，参数个数和类型已在编译期检查
+template <typename Out, typename... Args>
+static void log_fmt_write(Out &out, const LogFmtSpec &spec, const char *fmt,
+                          const Args &...args) {
+    unsigned piece = 0;
+    auto put_text = [&]() {
+        while (piece < spec.count && !spec.pieces[piece].field) {
+            out.put(fmt + spec.pieces[piece].begin, spec.pieces[piece].len);
+            ++piece;
+        }
+    };
+    [[maybe_unused]] auto put_value = [&](const auto &value) {
+        using Arg = log_fmt_arg_t<decltype(value)>;
+        put_text();
+        log_fmt_value<Out, Arg>(out, spec.pieces[piece++], Arg(value));
+    };
+    (put_value(args), ...);
+    put_text();
+}
+
+}  // namespace stroll
@@ -0,0 +1,509 @@
+/**
+ * @file log_sink.hpp
+ * @author stroll (116356647@qq.com)
+ * @brief 日志输出目标
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace stroll {
+
+/// @brief 日志输出目标接口，写入的是已经格式化好的完整日志行
+///
+/// 实现不能调用 sl_*，否则会递归回到自身。
+class LogSink {
+   public:
+    virtual ~LogSink() = default;
+
+    /// @brief 写入 size 字节
+    /// @return 输出目标未打开时返回 false，调用者改为写到 stdout
+    virtual bool write(const char *data, size_t size) = 0;
+
+    /// @brief 写完已接收的日志并关闭，之后 write 返回 false
+    virtual void close() {}
+};
+
+/// @brief 日志文件参数
+struct LogFileOptions {
+    std::string path;
+    uint64_t max_size = 0;           //< 单个文件的最大字节数，0 表示不按大小轮转
+    unsigned rotate_interval_s = 0;  //< 按时间轮转的周期，按 UTC 整点对齐，0 表示不按时间轮转
+    unsigned max_files = 5;          //< 保留的历史文件数 path.1 ~ path.N，0 表示轮转时直接丢弃
+    unsigned flush_ms = 100;         //< 缓冲区最长停留时间，小于 1ms 按 1ms 处理
+};
+
+/// @brief 带大缓冲区的日志文件输出
+///
+/// 写入只在互斥锁内拷贝到 1MB 的用户态缓冲区，写满或每隔 flush_ms 由后台线程把积攒的
+/// 缓冲区用一次 writev 以 O_APPEND 写出，大小和时间轮转也都在后台线程完成，
+/// 调用线程上没有系统调用。后台积压超过 kMaxPending 个缓冲区时新日志丢弃并计数。
+/// 实例不析构，进程退出时由 atexit 回调写完缓冲区并关闭文件，
+/// 因此应先打开文件再开启异步日志，退出时异步日志的剩余内容才能写进文件。
+class LogFileSink final : public LogSink {
+    static const size_t kBufferSize = 1024 * 1024;
+    static const size_t kMaxPending = 8;
+
+    struct Buffer {
+        std::unique_ptr<char[]> data;
+        size_t size = 0;
+    };
+
+   public:
+    static LogFileSink &instance() {
+        static LogFileSink *_inst = new LogFileSink;
+        return *_inst;
+    }
+
+    /// @brief 打开日志文件，已打开时先关闭原来的文件
+    /// @return 文件打开失败返回 false
+    bool open(const LogFileOptions &options) {
+        std::lock_guard guard(ctl_mtx_);
+        stop();
+
+        auto fd = ::open(options.path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        fd_ = fd;
+        file_size_ = fstat(fd, &st) == 0 ? st.st_size : 0;
+        options_ = options;
+        //< 为0时后台线程的等待立即超时，会空转占满一个核
+        options_.flush_ms = std::max(options.flush_ms, 1u);
+        next_rotate_ns_ = next_rotate_time(realtime_ns());
+
+        {
+            std::lock_guard lock(mtx_);
+            current_ = take_buffer();
+            opened_ = true;
+            exit_ = false;
+        }
+        flusher_ = std::thread(&LogFileSink::on_flush, this);
+        if (!atexit_registered_) {
+            atexit_registered_ = true;
+            std::atexit([]() { LogFileSink::instance().close(); });
+        }
+        return true;
+    }
+
+    /// @brief 写完缓冲区后关闭文件，之后 write 返回 false
+    void close() override {
+        std::lock_guard guard(ctl_mtx_);
+        stop();
+    }
+
+    bool write(const char *data, size_t size) override {
+        std::lock_guard lock(mtx_);
+        if (!opened_) {
+            return false;
+        }
+        if (size > kBufferSize - current_.size && pending_.size() >= kMaxPending) {
+            ++dropped_;
+            ++dropped_total_;
+            return true;
+        }
+        while (size > 0) {
+            if (current_.size == kBufferSize && !submit()) {
+                ++dropped_;
+                ++dropped_total_;
+                break;
+            }
+            auto len = std::min(size, kBufferSize - current_.size);
+            memcpy(current_.data.get() + current_.size, data, len);
+            current_.size += len;
+            data += len;
+            size -= len;
+        }
+        return true;
+    }
+
+    /// @brief 积压过多而丢弃的记录总数，包括已经写进文件提示的部分
+    uint64_t dropped() {
+        std::lock_guard lock(mtx_);
+        return dropped_total_;
+    }
+
+   private:
+    LogFileSink() = default;
+
+    static uint64_t realtime_ns() {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return ts.tv_sec * 1000ull * 1000 * 1000 + ts.tv_nsec;
+    }
+
+    /// @brief 从空闲列表取一个缓冲区，没有时分配，需要持有 mtx_
+    Buffer take_buffer() {
+        if (free_.empty()) {
+            Buffer buffer;
+            buffer.data.reset(new char[kBufferSize]);
+            return buffer;
+        }
+        auto buffer = std::move(free_.back());
+        free_.pop_back();
+        return buffer;
+    }
+
+    /// @brief 当前缓冲区交给后台线程，需要持有 mtx_
+    /// @return 积压过多时返回 false
+    bool submit() {
+        if (pending_.size() >= kMaxPending) {
+            return false;
+        }
+        pending_.push_back(std::move(current_));
+        current_ = take_buffer();
+        cond_.notify_one();
+        return true;
+    }
+
+    void stop() {
+        if (!flusher_.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard lock(mtx_);
+            opened_ = false;
+            exit_ = true;
+        }
+        cond_.notify_one();
+        flusher_.join();
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    void on_flush() {
+        std::vector<Buffer> batch;
+        std::unique_lock lock(mtx_);
+        while (true) {
+            cond_.wait_for(lock, std::chrono::milliseconds(options_.flush_ms),
+                           [this]() { return !pending_.empty() || exit_; });
+            if (current_.size != 0) {
+                pending_.push_back(std::move(current_));
+                current_ = take_buffer();
+            }
+            batch.swap(pending_);
+            auto dropped = std::exchange(dropped_, 0);
+            auto exit = exit_;
+
+            lock.unlock();
+            write_out(batch, dropped);
+            lock.lock();
+
+            for (auto &buffer : batch) {
+                buffer.size = 0;
+                free_.push_back(std::move(buffer));
+            }
+            batch.clear();
+            if (exit && pending_.empty()) {
+                break;
+            }
+        }
+    }
+
+    /// @brief 需要时先轮转，再用 writev 一次写出整批缓冲区，只在后台线程调用
+    void write_out(std::vector<Buffer> &batch, uint64_t dropped) {
+        std::vector<struct iovec> iov;
+        uint64_t total = 0;
+        for (auto &buffer : batch) {
+            iov.push_back({buffer.data.get(), buffer.size});
+            total += buffer.size;
+        }
+        char note[64];
+        if (dropped != 0) {
+            auto len = snprintf(note, sizeof(note), "[logger] %lu records dropped\n",
+                                (unsigned long)dropped);
+            iov.push_back({note, (size_t)len});
+            total += len;
+        }
+
+        auto now = realtime_ns();
+        if (file_size_ != 0 && ((options_.max_size != 0 && file_size_ + total > options_.max_size) ||
+                                now >= next_rotate_ns_)) {
+            rotate();
+        }
+        if (now >= next_rotate_ns_) {
+            next_rotate_ns_ = next_rotate_time(now);
+        }
+
+        if (!iov.empty()) {
+            write_all(iov.data(), iov.size());
+            file_size_ += total;
+        }
+    }
+
+    /// @brief writev 可能只写出一部分，逐段推进直到写完
+    void write_all(struct iovec *iov, size_t count) {
+        while (count > 0) {
+            auto len = ::writev(fd_, iov, std::min<size_t>(count, IOV_MAX));
+            if (len < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            while (count > 0 && (size_t)len >= iov->iov_len) {
+                len -= iov->iov_len;
+                ++iov;
+                --count;
+            }
+            if (count > 0) {
+                iov->iov_base = (char *)iov->iov_base + len;
+                iov->iov_len -= len;
+            }
+        }
+    }
+
+    /// @brief path.N-1 依次改名为 path.N，当前文件改名为 path.1 后重新打开
+    void rotate() {
+        auto &path = options_.path;
+        if (options_.max_files == 0) {
+            ::unlink(path.c_str());
+        } else {
+            for (auto i = options_.max_files - 1; i >= 1; --i) {
+                ::rename((path + "." + std::to_string(i)).c_str(),
+                         (path + "." + std::to_string(i + 1)).c_str());
+            }
+            ::rename(path.c_str(), (path + ".1").c_str());
+        }
+
+        auto fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            //< 新文件打不开时继续写旧文件
+            return;
+        }
+        ::close(fd_);
+        fd_ = fd;
+        file_size_ = 0;
+    }
+
+    uint64_t next_rotate_time(uint64_t now) const {
+        if (options_.rotate_interval_s == 0) {
+            return UINT64_MAX;
+        }
+        auto interval = options_.rotate_interval_s * 1000ull * 1000 * 1000;
+        return (now / interval + 1) * interval;
+    }
+
+   private:
+    std::mutex ctl_mtx_;  //< 串行化 open/close
+    std::thread flusher_;
+    bool atexit_registered_ = false;
+
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    Buffer current_;
+    std::vector<Buffer> pending_;
+    std::vector<Buffer> free_;
+    uint64_t dropped_ = 0;        //< 尚未写进文件提示的丢弃数
+    uint64_t dropped_total_ = 0;  //< 累计丢弃数
+    bool opened_ = false;
+    bool exit_ = false;
+
+    //< 以下只由后台线程访问
+    LogFileOptions options_;
+    int fd_ = -1;
+    uint64_t file_size_ = 0;
+    uint64_t next_rotate_ns_ = UINT64_MAX;
+};
+
+/// @brief 内存映射日志文件参数
+struct LogMmapOptions {
+    std::string path;
+    size_t chunk_size = 64 * 1024 * 1024;  //< 每次预分配并映射的大小，按页向上取整
+    size_t sync_size = 4 * 1024 * 1024;    //< 写入游标每前进这么多，异步回写并释放其后的页
+};
+
+/// @brief 基于内存映射的日志文件输出
+///
+/// 文件按 chunk_size 用 fallocate 预分配后整段映射，写入就是一次 memcpy，
+/// 没有 write 系统调用，也没有用户态到页缓存的拷贝。写到映射末尾时映射下一段；
+/// 游标之后每满 sync_size 对已写完的部分 msync(MS_ASYNC) 并 madvise(DONTNEED)，
+/// 进程常驻内存不会随日志增长。适合后台线程单独写入的异步和延迟日志。
+/// 关闭时把文件截断到实际长度；进程崩溃时文件末尾会留有预分配的 0 字节。
+/// 不做轮转。
+class LogMmapSink final : public LogSink {
+   public:
+    static LogMmapSink &instance() {
+        static LogMmapSink *_inst = new LogMmapSink;
+        return *_inst;
+    }
+
+    /// @brief 打开日志文件，追加在原有内容之后，已打开时先关闭原来的文件
+    /// @return 文件打开、预分配或映射失败返回 false
+    bool open(const LogMmapOptions &options) {
+        std::lock_guard guard(mtx_);
+        close_locked();
+
+        auto fd = ::open(options.path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+
+        auto page = (size_t)sysconf(_SC_PAGESIZE);
+        fd_ = fd;
+        chunk_size_ = std::max(page, (options.chunk_size + page - 1) / page * page);
+        sync_size_ = std::max(page, options.sync_size / page * page);
+        offset_ = st.st_size;
+        if (!map(offset_ / page * page)) {
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        if (!atexit_registered_) {
+            atexit_registered_ = true;
+            std::atexit([]() { LogMmapSink::instance().close(); });
+        }
+        return true;
+    }
+
+    void close() override {
+        std::lock_guard guard(mtx_);
+        close_locked();
+    }
+
+    bool write(const char *data, size_t size) override {
+        std::lock_guard guard(mtx_);
+        if (!map_) {
+            return false;
+        }
+        while (size > 0) {
+            auto pos = offset_ - map_offset_;
+            if (pos == chunk_size_ && !map(offset_)) {
+                //< 映射失败后剩余部分丢弃，之后的日志改写到 stdout
+                return true;
+            }
+            pos = offset_ - map_offset_;
+            auto len = std::min(size, chunk_size_ - pos);
+            memcpy(map_ + pos, data, len);
+            offset_ += len;
+            data += len;
+            size -= len;
+            if (offset_ - synced_ >= sync_size_) {
+                release(offset_ / sync_size_ * sync_size_);
+            }
+        }
+        return true;
+    }
+
+   private:
+    LogMmapSink() = default;
+
+    /// @brief 预分配并映射从 offset 开始的一段，offset 按页对齐，需要持有 mtx_
+    bool map(size_t offset) {
+        unmap();
+        auto ret = fallocate(fd_, 0, offset, chunk_size_);
+        if (ret != 0 && (errno == EOPNOTSUPP || errno == ENOSYS)) {
+            //< 文件系统不支持预分配时退化为扩展文件长度
+            struct stat st;
+            ret = fstat(fd_, &st) == 0 && (size_t)st.st_size >= offset + chunk_size_
+                      ? 0
+                      : ftruncate(fd_, offset + chunk_size_);
+        }
+        if (ret != 0) {
+            return false;
+        }
+        auto addr = mmap(nullptr, chunk_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, offset);
+        if (addr == MAP_FAILED) {
+            return false;
+        }
+        madvise(addr, chunk_size_, MADV_SEQUENTIAL);
+        map_ = (char *)addr;
+        map_offset_ = offset;
+        synced_ = std::max(offset, offset_ / sync_size_ * sync_size_);
+        populate(synced_);
+        return true;
+    }
+
+    /// @brief 回写并释放 [synced_, end) 已写完的页，需要持有 mtx_
+    void release(size_t end) {
+        if (end <= synced_) {
+            return;
+        }
+        auto addr = map_ + (synced_ - map_offset_);
+        msync(addr, end - synced_, MS_ASYNC);
+        madvise(addr, end - synced_, MADV_DONTNEED);
+        synced_ = end;
+        populate(end);
+    }
+
+    /// @brief 预先以可写方式建立 [begin, begin + sync_size_) 的页表，
+    /// 写入时不再逐页缺页，内核不支持时什么也不做
+    void populate(size_t begin) {
+#ifdef MADV_POPULATE_WRITE
+        auto end = std::min(begin + sync_size_, map_offset_ + chunk_size_);
+        if (begin < end) {
+            madvise(map_ + (begin - map_offset_), end - begin, MADV_POPULATE_WRITE);
+        }
+#else
+        (void)begin;
+#endif
+    }
+
+    void unmap() {
+        if (!map_) {
+            return;
+        }
+        msync(map_, chunk_size_, MS_ASYNC);
+        munmap(map_, chunk_size_);
+        map_ = nullptr;
+    }
+
+    void close_locked() {
+        if (fd_ < 0) {
+            return;
+        }
+        unmap();
+        //< 去掉预分配但还没写入的部分
+        if (ftruncate(fd_, offset_) != 0) {
+            fprintf(stderr, "[logger] truncate log file failed: %s\n", strerror(errno));
+        }
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+   private:
+    std::mutex mtx_;
+    bool atexit_registered_ = false;
+    int fd_ = -1;
+    size_t chunk_size_ = 0;
+    size_t sync_size_ = 0;
+    char *map_ = nullptr;
+    size_t map_offset_ = 0;  //< 当前映射在文件中的偏移
+    size_t offset_ = 0;      //< 写入游标
+    size_t synced_ = 0;      //< 此前的页已回写并释放
+};
+
+}  // namespace stroll
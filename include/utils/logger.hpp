@@ -10,8 +10,33 @@
  */
 
 #pragma once
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <csignal>
+#include <cstdarg>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "utils/clock.hpp"
+#include "utils/futex.hpp"
+#include "utils/log_format.hpp"
+#include "utils/log_sink.hpp"
+#include "utils/mpmc_queue.hpp"
 
 namespace stroll {
 
@@ -38,36 +63,1605 @@ static const char *const level_text[] = {
 #define TAG "tag"
 #define PATH_SEP '/'
 
-static inline const char *log_base_file_name(const char *file_name) {
-    unsigned index = 0;
-    for (auto i = 0u; file_name[i] != '\0'; ++i) {
-        if (file_name[i] == PATH_SEP) {
-            index = i;
+/// @brief 编译期最低日志级别，取值同 LogLevel(0~3)，更详细级别的 sl_* 连同参数求值一起被移除
+#ifndef STROLL_LOG_MIN_LEVEL
+#define STROLL_LOG_MIN_LEVEL 3
+#endif
+
+/// @brief 取路径中的文件名，constexpr，用于调用点描述符时在编译期求值
+static constexpr const char *log_base_file_name(const char *file_name) {
+    auto base = file_name;
+    for (auto p = file_name; *p != '\0'; ++p) {
+        if (*p == PATH_SEP) {
+            base = p + 1;
+        }
+    }
+    return base;
+}
+
+#ifdef __FILE_NAME__
+#define SL_FILE_NAME __FILE_NAME__
+#else
+#define SL_FILE_NAME stroll::log_base_file_name(__FILE__)
+#endif
+
+/// @brief 飞行记录器开关，为0时 sl_* 只按日志级别输出，不再记录
+#ifndef STROLL_FLIGHT_RECORDER
+#define STROLL_FLIGHT_RECORDER 1
+#endif
+
+/// @brief 飞行记录器每个线程的记录条数，每条128字节
+#ifndef STROLL_FLIGHT_RECORDER_SLOTS
+#define STROLL_FLIGHT_RECORDER_SLOTS 8192
+#endif
+
+/// @brief 日志输出方式，sl_* 每次调用只做一次 relaxed 读来选择
+enum LogMode {
+    kLogSync = 0,  //< 在调用线程上格式化并 printf
+    kLogAsync,     //< AsyncLogger
+    kLogDeferred,  //< DeferredLogger
+};
+
+/// @brief 日志时间戳格式，DeferredLogger 按后台线程格式化时的设置输出
+enum LogTimeFormat {
+    kLogTimeLocal = 0,  //< 本地时间 YYYY-MM-DD HH:MM:SS.mmm
+    kLogTimeRaw,        //< 单调时钟的秒数，精确到ns，可用 invariant TSC 时直接读取 TSC
+};
+
+/// @brief 日志全局配置
+///
+/// 异步模式下不超过 LogRecord::kMsgSize 的正文直接放在队列条目中，更长的正文在堆上分配；
+/// 异步和延迟模式下单条日志超过后台批量缓冲区(64KB)的部分会被截断。
+struct LogConfig {
+    static constexpr int kFollowLevel = -1;  //< record_level 取此值时跟随运行时日志级别
+
+    static inline std::atomic<int> mode{kLogSync};
+    static inline std::atomic<int> level{kDebug};  //< 运行时日志级别
+    static inline std::atomic<int> record_level{kDebug};  //< 写入飞行记录器的级别，默认全部记录
+    static inline std::atomic<int> active_level{kDebug};  //< level 和 record_level 中较详细的一个
+    static inline std::atomic<int> time_format{kLogTimeLocal};
+    static inline std::atomic<bool> color{isatty(STDOUT_FILENO) != 0};  //< 输出到终端时才带颜色
+    static inline std::atomic<LogSink *> sink{nullptr};                //< 为空时输出到 stdout
+};
+
+static inline LogMode log_mode() { return (LogMode)LogConfig::mode.load(std::memory_order_relaxed); }
+
+/// @brief 飞行记录器实际使用的级别
+static inline int log_record_level() {
+    auto level = LogConfig::record_level.load(std::memory_order_relaxed);
+    return level == LogConfig::kFollowLevel ? LogConfig::level.load(std::memory_order_relaxed)
+                                            : level;
+}
+
+/// @brief 级别变化后重新计算调用处判断用的 active_level
+static inline void log_update_active_level() {
+    auto level = LogConfig::level.load();
+    LogConfig::active_level.store(STROLL_FLIGHT_RECORDER ? std::max(level, log_record_level())
+                                                         : level);
+}
+
+/// @brief 设置运行时日志级别，比 level 更详细且不写入飞行记录器的日志在调用处只付出一次 relaxed 读
+static inline void set_log_level(LogLevel level) {
+    LogConfig::level.store(level);
+    log_update_active_level();
+}
+
+/// @brief level 级别的日志是否会输出
+static inline bool log_enabled(LogLevel level) {
+    return level <= LogConfig::level.load(std::memory_order_relaxed);
+}
+
+/// @brief level 级别的日志是否需要输出或写入飞行记录器，sl_* 在调用处只做这一次判断
+static inline bool log_active(LogLevel level) {
+    return level <= LogConfig::active_level.load(std::memory_order_relaxed);
+}
+
+static inline void set_log_time_format(LogTimeFormat format) { LogConfig::time_format.store(format); }
+
+/// @brief 是否输出 ANSI 颜色，默认只在 stdout 是终端时开启
+static inline void set_log_color(bool enable) { LogConfig::color.store(enable); }
+
+/// @brief 关闭颜色时返回空串
+static inline const char *log_color(const char *color) {
+    return LogConfig::color.load(std::memory_order_relaxed) ? color : "";
+}
+
+/// @brief 写出已格式化的日志，设置了输出目标时写入输出目标，否则写到 stdout
+static inline void log_write(const char *data, size_t size) {
+    auto sink = LogConfig::sink.load(std::memory_order_acquire);
+    if (!sink || !sink->write(data, size)) {
+        fwrite(data, 1, size, stdout);
+    }
+}
+
+/// @brief 切换输出目标，写完并关闭原来的输出目标，sink 为空时恢复输出到 stdout
+///
+/// 输出到文件时关闭颜色，恢复 stdout 时按 stdout 是否为终端决定。
+static inline void log_set_sink(LogSink *sink) {
+    LogConfig::color.store(sink ? false : isatty(STDOUT_FILENO) != 0);
+    auto old = LogConfig::sink.exchange(sink, std::memory_order_acq_rel);
+    if (old && old != sink) {
+        old->close();
+    }
+}
+
+/// @brief 日志改为写入文件
+/// @return 文件打开失败返回 false，继续输出到原来的位置
+static inline bool log_to_file(const LogFileOptions &options) {
+    auto &sink = LogFileSink::instance();
+    if (!sink.open(options)) {
+        return false;
+    }
+    log_set_sink(&sink);
+    return true;
+}
+
+/// @brief 日志改为写入内存映射文件，适合与异步或延迟日志配合
+/// @return 文件打开或映射失败返回 false，继续输出到原来的位置
+static inline bool log_to_mmap(const LogMmapOptions &options) {
+    auto &sink = LogMmapSink::instance();
+    if (!sink.open(options)) {
+        return false;
+    }
+    log_set_sink(&sink);
+    return true;
+}
+
+/// @brief 日志恢复输出到 stdout
+static inline void log_to_stdout() { log_set_sink(nullptr); }
+
+static inline bool log_time_raw() {
+    return LogConfig::time_format.load(std::memory_order_relaxed) == kLogTimeRaw;
+}
+
+/// @brief 读取日志时间戳，单位为ns，本地时间格式读 CLOCK_REALTIME，原始格式读单调时钟
+static inline uint64_t log_now_ns(bool raw) {
+    if (raw) {
+        return TscClock::instance().now_ns();
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec * 1000ull * 1000 * 1000 + ts.tv_nsec;
+}
+
+/// @brief 把 value 写成 width 位十进制数，不足补0
+static inline void log_put_digits(char *out, uint64_t value, unsigned width) {
+    for (auto i = width; i > 0; --i) {
+        out[i - 1] = '0' + value % 10;
+        value /= 10;
+    }
+}
+
+/// @brief 格式化日志时间戳，结果在线程私有缓冲区中，下次调用前有效
+///
+/// 本地时间只在秒变化时调用 localtime_r 重新格式化 "YYYY-MM-DD HH:MM:SS"，
+/// 毫秒直接写入缓存的字符串，避开 glibc 时区锁和逐字段 printf。
+static inline const char *log_time_text(uint64_t ns, bool raw) {
+    static const uint64_t kNsPerSec = 1000ull * 1000 * 1000;
+    thread_local struct {
+        time_t sec = -1;
+        char local[sizeof("YYYY-MM-DD HH:MM:SS.mmm")];
+        char raw[32];
+    } cache;
+
+    if (raw) {
+        auto sec = ns / kNsPerSec;
+        auto len = 1u;
+        for (auto value = sec; value >= 10; value /= 10) {
+            ++len;
+        }
+        log_put_digits(cache.raw, sec, len);
+        cache.raw[len] = '.';
+        log_put_digits(cache.raw + len + 1, ns % kNsPerSec, 9);
+        cache.raw[len + 10] = '\0';
+        return cache.raw;
+    }
+
+    time_t sec = ns / kNsPerSec;
+    if (sec != cache.sec) {
+        struct tm datetime;
+        localtime_r(&sec, &datetime);
+        memcpy(cache.local, "YYYY-MM-DD HH:MM:SS.mmm", sizeof(cache.local));
+        log_put_digits(cache.local, datetime.tm_year + 1900, 4);
+        log_put_digits(cache.local + 5, datetime.tm_mon + 1, 2);
+        log_put_digits(cache.local + 8, datetime.tm_mday, 2);
+        log_put_digits(cache.local + 11, datetime.tm_hour, 2);
+        log_put_digits(cache.local + 14, datetime.tm_min, 2);
+        log_put_digits(cache.local + 17, datetime.tm_sec, 2);
+        cache.sec = sec;
+    }
+    log_put_digits(cache.local + 20, ns % kNsPerSec / 1000 / 1000, 3);
+    return cache.local;
+}
+
+/// @brief 日志调用点的静态信息，每个 sl_* 调用处一份，编译期常量初始化
+///
+/// 输出时只传递指向它的指针，文件名、函数名、行号、级别和格式串都不再逐次计算和传参。
+struct LogSite {
+    const char *color;
+    const char *tag;
+    LogLevel level;
+    const char *file;
+    const char *func;
+    int line;
+    const char *fmt;
+    const LogFmtSpec *spec;  //< slf_* 调用点在编译期解析好的格式串，sl_* 为空
+};
+
+/// @brief 后台线程使用的批量输出缓冲区，补齐时间前缀后攒批写出
+class LogBatch {
+    static const size_t kSize = 64 * 1024;
+    static const size_t kReserve = 1024;  //< 单条日志预留的空间，不足时先写出
+
+   public:
+    /// @brief 追加一条日志，body 负责把正文写入给定的空间并返回长度
+    template <typename Body>
+    void append(uint64_t ns, bool raw, const LogSite &site, Body &&body) {
+        if (size_ + kReserve > kSize) {
+            flush();
+        }
+
+        advance(snprintf(buffer_ + size_, kSize - size_, "%s[%s][%s][%s][%s:%s:%d] ", log_color(site.color),
+                         log_time_text(ns, raw), site.tag, level_text[site.level], site.file,
+                         site.func, site.line));
+        advance(body(buffer_ + size_, kSize - size_ - sizeof(NORAL_TEXT_COLOR)));
+        advance(snprintf(buffer_ + size_, kSize - size_, "%s", log_color(NORAL_TEXT_COLOR)));
+    }
+
+    void report_dropped(uint64_t dropped) {
+        if (dropped == 0) {
+            return;
+        }
+        if (size_ + kReserve > kSize) {
+            flush();
+        }
+        advance(snprintf(buffer_ + size_, kSize - size_, "%s[logger] %lu records dropped\n%s",
+                         log_color(WARN_TEXT_COLOR), (unsigned long)dropped,
+                         log_color(NORAL_TEXT_COLOR)));
+    }
+
+    void flush() {
+        if (size_ == 0) {
+            return;
+        }
+        log_write(buffer_, size_);
+        fflush(stdout);
+        size_ = 0;
+    }
+
+   private:
+    /// @brief snprintf 截断时返回的是完整长度，这里按实际写入的长度前进
+    void advance(int len) { size_ += std::min<size_t>(std::max(len, 0), kSize - size_ - 1); }
+
+   private:
+    char buffer_[kSize];
+    size_t size_ = 0;
+};
+
+/// @brief 一条待输出的日志，调用线程只填充时间和消息正文
+struct LogRecord {
+    static const unsigned kMsgSize = 200;
+
+    uint64_t ns;
+    bool raw;  //< ns 为单调时钟
+    const LogSite *site;
+    unsigned len;
+    char *spill;  //< 正文放不进 msg 时在堆上分配，由后台线程输出后释放
+    char msg[kMsgSize];
+
+    const char *body() const { return spill ? spill : msg; }
+};
+
+/// @brief 异步日志后端
+///
+/// 开启后 sl_* 只读取时间、格式化消息正文并放入无锁队列，不再调用 localtime_r 和 printf；
+/// 后台线程负责格式化时间前缀，攒成批后一次写出。队列满时丢弃并计数，调用线程永不阻塞。
+/// 实例不析构，进程退出时由 atexit 回调把队列中剩余的日志写完。
+class AsyncLogger {
+    static const size_t kQueueSize = 8192;
+
+   public:
+    static AsyncLogger &instance() {
+        static AsyncLogger *_inst = new AsyncLogger;
+        return *_inst;
+    }
+
+    /// @brief 开启异步输出
+    void start() {
+        std::lock_guard guard(mtx_);
+        if (writer_.joinable()) {
+            return;
+        }
+        exit_ = false;
+        writer_ = std::thread(&AsyncLogger::on_write, this);
+        if (!atexit_registered_) {
+            atexit_registered_ = true;
+            std::atexit([]() { AsyncLogger::instance().stop(); });
+        }
+        LogConfig::mode = kLogAsync;
+    }
+
+    /// @brief 关闭异步输出，写完队列中的日志后返回，之后 sl_* 恢复同步输出
+    void stop() {
+        std::lock_guard guard(mtx_);
+        if (!writer_.joinable()) {
+            return;
+        }
+        int mode = kLogAsync;
+        LogConfig::mode.compare_exchange_strong(mode, kLogSync);
+        exit_ = true;
+        wakeup();
+        writer_.join();
+    }
+
+    /// @brief 参数与 site->fmt 匹配，格式检查由 sl_* 宏在编译期完成
+    void log(const LogSite *site, ...) {
+        va_list args;
+        va_start(args, site);
+        write(site, [&](char *out, size_t size) {
+            //< 正文过长时会再调用一次，每次使用参数的副本
+            va_list copy;
+            va_copy(copy, args);
+            auto len = vsnprintf(out, size, site->fmt, copy);
+            va_end(copy);
+            return len;
+        });
+        va_end(args);
+    }
+
+    /// @brief body 把消息正文写入给定的空间，返回完整正文的长度
+    ///
+    /// 正文放不进 LogRecord::msg 时分配堆空间并再调用一次 body，长消息不会被截断。
+    template <typename Body>
+    void write(const LogSite *site, Body &&body) {
+        LogRecord record;
+        record.raw = log_time_raw();
+        record.ns = log_now_ns(record.raw);
+        record.site = site;
+        record.spill = nullptr;
+        auto len = std::max(body(record.msg, sizeof(record.msg)), 0);
+        if ((size_t)len >= sizeof(record.msg)) {
+            record.spill = new char[len + 1];
+            len = std::min(std::max(body(record.spill, len + 1), 0), len);
+        }
+        record.len = len;
+
+        if (!queue_.push(record)) {
+            delete[] record.spill;
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
         }
+        //< 入队的 release 写与读 sleeping_ 之间可能重排，与 on_write 中的栅栏配对
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load()) {
+            wakeup();
+        }
+    }
+
+   private:
+    AsyncLogger() = default;
+
+    void wakeup() {
+        ready_seq_.fetch_add(1);
+        futex_wake(ready_seq_, 1);
+    }
+
+    void on_write() {
+        LogRecord record;
+        while (true) {
+            auto count = 0u;
+            while (queue_.pop(record)) {
+                format(record);
+                ++count;
+            }
+            batch_.report_dropped(dropped_.exchange(0, std::memory_order_relaxed));
+            batch_.flush();
+
+            if (count != 0) {
+                continue;
+            }
+            if (exit_) {
+                break;
+            }
+
+            //< 先公布休眠再检查队列，与 write 中先入队再检查 sleeping_ 配合，不会漏掉唤醒；
+            //< 两侧的栅栏保证至少一方能看到另一方的写入
+            sleeping_ = true;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto seq = ready_seq_.load();
+            if (queue_.pop(record)) {
+                sleeping_ = false;
+                format(record);
+                continue;
+            }
+            if (!exit_) {
+                futex_wait(ready_seq_, seq);
+            }
+            sleeping_ = false;
+        }
+    }
+
+    void format(const LogRecord &record) {
+        batch_.append(record.ns, record.raw, *record.site, [&record](char *out, size_t size) {
+            auto len = std::min<size_t>(record.len, size);
+            memcpy(out, record.body(), len);
+            return (int)len;
+        });
+        delete[] record.spill;
+    }
+
+   private:
+    MpmcQueue<LogRecord> queue_{kQueueSize};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint32_t> ready_seq_{0};  //< 入队后递增，后台线程在此休眠
+    std::atomic<bool> sleeping_{false};
+    std::atomic<bool> exit_{false};
+    std::mutex mtx_;
+    std::thread writer_;
+    bool atexit_registered_ = false;
+    LogBatch batch_;  //< 只由后台线程访问
+};
+
+/// @brief 不带格式检查的 snprintf，供 DeferredLogger 用调用点的格式串格式化
+static inline int log_snprintf(char *out, size_t size, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    auto len = vsnprintf(out, size, fmt, args);
+    va_end(args);
+    return len;
+}
+
+/// @brief 单个参数的二进制编解码，算术类型和指针直接拷贝字节
+template <typename T>
+struct LogArg {
+    static_assert(std::is_trivially_copyable_v<T>, "deferred log arguments must be printf types");
+
+    static size_t size(const T &) { return sizeof(T); }
+
+    static char *encode(char *out, const T &value) {
+        memcpy(out, &value, sizeof(T));
+        return out + sizeof(T);
+    }
+
+    static T decode(const char *&in) {
+        T value;
+        memcpy(&value, in, sizeof(T));
+        in += sizeof(T);
+        return value;
+    }
+};
+
+/// @brief 字符串按值拷贝：长度加上包括结尾 0 的内容，空指针长度记为 UINT32_MAX
+template <>
+struct LogArg<const char *> {
+    static const uint32_t kNull = UINT32_MAX;
+
+    static size_t size(const char *value) {
+        return sizeof(uint32_t) + (value ? strlen(value) + 1 : 0);
+    }
+
+    static char *encode(char *out, const char *value) {
+        uint32_t len = value ? strlen(value) : kNull;
+        memcpy(out, &len, sizeof(len));
+        out += sizeof(len);
+        if (value) {
+            memcpy(out, value, len + 1);
+            out += len + 1;
+        }
+        return out;
+    }
+
+    static const char *decode(const char *&in) {
+        uint32_t len;
+        memcpy(&len, in, sizeof(len));
+        in += sizeof(len);
+        if (len == kNull) {
+            return nullptr;
+        }
+        auto value = in;
+        in += len + 1;
+        return value;
+    }
+};
+
+/// @brief 异步信号安全的输出缓冲，只用 write 系统调用，供崩溃时转储使用
+class LogSafeWriter {
+   public:
+    explicit LogSafeWriter(int fd) : fd_(fd) {}
+    ~LogSafeWriter() { flush(); }
+
+    LogSafeWriter(const LogSafeWriter &) = delete;
+    LogSafeWriter &operator=(const LogSafeWriter &) = delete;
+
+    void put(char c) {
+        if (size_ == sizeof(buffer_)) {
+            flush();
+        }
+        buffer_[size_++] = c;
+        last_ = c;
+    }
+
+    void put(const char *text) {
+        for (text = text ? text : "(null)"; *text != '\0'; ++text) {
+            put(*text);
+        }
+    }
+
+    void put(const char *text, size_t len) {
+        for (auto i = 0u; i < len; ++i) {
+            put(text[i]);
+        }
+    }
+
+    void put_uint(uint64_t value, unsigned base = 10) {
+        char digits[24];
+        auto len = 0u;
+        do {
+            digits[len++] = "0123456789abcdef"[value % base];
+            value /= base;
+        } while (value != 0);
+        while (len > 0) {
+            put(digits[--len]);
+        }
+    }
+
+    void put_int(int64_t value) {
+        if (value < 0) {
+            put('-');
+            put_uint(0 - (uint64_t)value);
+        } else {
+            put_uint(value);
+        }
+    }
+
+    /// @brief 定点输出，保留6位小数，超出 uint64_t 范围的值只输出数量级
+    void put_double(double value) {
+        if (value != value) {
+            put("nan");
+            return;
+        }
+        if (value < 0) {
+            put('-');
+            value = -value;
+        }
+        if (value >= 1.8e19) {
+            put(value == value * 2 ? "inf" : ">1e19");
+            return;
+        }
+        auto integer = (uint64_t)value;
+        auto fraction = (uint64_t)((value - integer) * 1000000 + 0.5);
+        if (fraction >= 1000000) {
+            ++integer;
+            fraction -= 1000000;
+        }
+        put_uint(integer);
+        put('.');
+        char digits[6];
+        log_put_digits(digits, fraction, sizeof(digits));
+        for (auto c : digits) {
+            put(c);
+        }
+    }
+
+    /// @brief 补齐行尾换行
+    void end_line() {
+        if (last_ != '\n') {
+            put('\n');
+        }
+    }
+
+    void flush() {
+        auto data = buffer_;
+        while (size_ > 0) {
+            auto len = ::write(fd_, data, size_);
+            if (len < 0 && errno == EINTR) {
+                continue;
+            }
+            if (len <= 0) {
+                break;
+            }
+            data += len;
+            size_ -= len;
+        }
+        size_ = 0;
+    }
+
+   private:
+    int fd_;
+    size_t size_ = 0;
+    char last_ = '\n';
+    char buffer_[512];
+};
+
+/// @brief 输出格式串中下一个转换说明之前的文字，返回转换字符，没有更多转换说明时返回 0
+static inline char log_safe_text(const char *&fmt, LogSafeWriter &out) {
+    while (*fmt != '\0') {
+        auto c = *fmt++;
+        if (c != '%') {
+            out.put(c);
+            continue;
+        }
+        if (*fmt == '%') {
+            out.put(*fmt++);
+            continue;
+        }
+        //< 跳过标志、宽度、精度和长度修饰
+        while (*fmt != '\0' && strchr("-+ #0123456789.*hljztLq'", *fmt)) {
+            ++fmt;
+        }
+        if (*fmt != '\0') {
+            return *fmt++;
+        }
+    }
+    return 0;
+}
+
+/// @brief 按转换字符输出一个参数，宽度和精度被忽略
+template <typename T>
+static void log_safe_arg(const char *&fmt, LogSafeWriter &out, const T &value) {
+    auto conv = log_safe_text(fmt, out);
+    if constexpr (std::is_same_v<T, const char *>) {
+        out.put(value);
+    } else if constexpr (std::is_pointer_v<T>) {
+        out.put("0x");
+        out.put_uint((uintptr_t)value, 16);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        out.put_double(value);
+    } else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+        if (conv == 'c') {
+            out.put((char)value);
+        } else if (conv == 'x' || conv == 'X' || conv == 'p') {
+            out.put_uint((uint64_t)value, 16);
+        } else if (std::is_signed_v<T> && conv != 'u') {
+            out.put_int((int64_t)value);
+        } else {
+            out.put_uint((uint64_t)value);
+        }
+    } else {
+        out.put('?');
+    }
+}
+
+/// @brief string_view 按值拷贝：长度加上内容，不要求以 0 结尾
+template <>
+struct LogArg<std::string_view> {
+    static size_t size(std::string_view value) { return sizeof(uint32_t) + value.size(); }
+
+    static char *encode(char *out, std::string_view value) {
+        uint32_t len = value.size();
+        memcpy(out, &len, sizeof(len));
+        memcpy(out + sizeof(len), value.data(), len);
+        return out + sizeof(len) + len;
+    }
+
+    static std::string_view decode(const char *&in) {
+        uint32_t len;
+        memcpy(&len, in, sizeof(len));
+        std::string_view value(in + sizeof(len), len);
+        in += sizeof(len) + len;
+        return value;
+    }
+};
+
+/// @brief 参数存储类型：数组退化为指针，char * 按字符串处理
+template <typename T>
+using log_arg_t = std::conditional_t<std::is_same_v<std::decay_t<T>, char *>, const char *,
+                                     std::decay_t<T>>;
+
+/// @brief 一组参数的编解码，format 在后台线程按原类型还原参数后格式化
+template <typename... Args>
+struct LogArgs {
+    static size_t size(const Args &...args) { return (size_t(0) + ... + LogArg<Args>::size(args)); }
+
+    static void encode(char *out, const Args &...args) {
+        ((out = LogArg<Args>::encode(out, args)), ...);
+    }
+
+    static int format(const LogSite &site, const char *in, char *out, size_t size) {
+        //< 花括号初始化保证按从左到右的顺序解码
+        std::tuple<Args...> values{LogArg<Args>::decode(in)...};
+        return std::apply(
+            [&](const auto &...value) { return log_snprintf(out, size, site.fmt, value...); },
+            values);
+    }
+
+    /// @brief 不用 printf 的格式化，异步信号安全，供崩溃转储使用
+    static void dump(const LogSite &site, const char *in, LogSafeWriter &out) {
+        std::tuple<Args...> values{LogArg<Args>::decode(in)...};
+        auto fmt = site.fmt;
+        std::apply([&](const auto &...value) { (log_safe_arg(fmt, out, value), ...); }, values);
+        while (log_safe_text(fmt, out) != 0) {
+        }
+    }
+};
+
+/// @brief slf_* 的参数编解码，按调用点编译期解析的格式串格式化，不经过 printf
+template <typename... Args>
+struct LogFmtArgs : LogArgs<Args...> {
+    static int format(const LogSite &site, const char *in, char *out, size_t size) {
+        std::tuple<Args...> values{LogArg<Args>::decode(in)...};
+        LogFmtBuffer buffer(out, size);
+        std::apply([&](const auto &...value) { log_fmt_write(buffer, *site.spec, site.fmt, value...); },
+                   values);
+        return buffer.size();
+    }
+
+    static void dump(const LogSite &site, const char *in, LogSafeWriter &out) {
+        std::tuple<Args...> values{LogArg<Args>::decode(in)...};
+        std::apply([&](const auto &...value) { log_fmt_write(out, *site.spec, site.fmt, value...); },
+                   values);
+    }
+};
+
+/// @brief 延迟格式化日志，参考 NanoLog
+///
+/// 调用线程只把调用点指针、格式化函数、时间戳和参数的原始字节写入线程私有的环形缓冲区，
+/// 不解析格式串；后台线程轮询各线程的缓冲区，按调用点类型还原参数后再格式化输出。
+/// 缓冲区满时丢弃并计数。不同线程的日志各自有序，线程之间不保证按时间排序。
+class DeferredLogger {
+    static constexpr uint64_t kPollMs = 1;
+
+    /// @brief 记录头，后面紧跟参数字节，整条记录按8字节对齐
+    struct Header {
+        uint32_t size;  //< 为0表示缓冲区尾部的回绕标记
+        uint32_t tsc;   //< ns 中是否为未换算的 TSC 读数
+        const LogSite *site;
+        int (*format)(const LogSite &, const char *, char *, size_t);
+        uint64_t ns;  //< 单调时间或 TSC 读数，由后台线程换算
+    };
+
+    /// @brief 线程私有的单生产者单消费者字节环
+    struct StagingBuffer {
+        static const size_t kSize = 256 * 1024;
+
+        /// @brief 预留 n 字节的连续空间，空间不足返回空
+        char *reserve(size_t n) {
+            auto head = head_.load(std::memory_order_relaxed);
+            auto pos = head % kSize;
+            if (pos + n > kSize) {
+                //< 尾部放不下，写回绕标记后从头开始
+                if (!has_space(head + (kSize - pos) + n)) {
+                    return nullptr;
+                }
+                uint32_t wrap = 0;
+                memcpy(data_ + pos, &wrap, sizeof(wrap));
+                head += kSize - pos;
+                head_.store(head, std::memory_order_release);
+                pos = 0;
+            }
+            if (!has_space(head + n)) {
+                return nullptr;
+            }
+            return data_ + pos;
+        }
+
+        /// @brief 写到 end 是否不会覆盖未读的数据，先用缓存的读位置判断，不够时才读取 tail_
+        bool has_space(size_t end) {
+            if (end - tail_cache_ <= kSize) {
+                return true;
+            }
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            return end - tail_cache_ <= kSize;
+        }
+
+        void commit(size_t n) {
+            head_.store(head_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+        }
+
+        char data_[kSize];
+        alignas(64) std::atomic<size_t> head_{0};
+        size_t tail_cache_ = 0;  //< 生产者看到的 tail_，只由所属线程访问
+        alignas(64) std::atomic<size_t> tail_{0};
+        std::atomic<uint64_t> dropped_{0};
+        std::atomic<bool> retired_{false};  //< 所属线程已退出，读完后释放
+    };
+
+    /// @brief 线程退出时标记缓冲区，由后台线程读完后释放
+    struct BufferOwner {
+        StagingBuffer *buffer = nullptr;
+        ~BufferOwner() {
+            if (buffer) {
+                buffer->retired_.store(true, std::memory_order_release);
+            }
+            buffer = nullptr;
+            cached() = nullptr;
+            exited() = true;
+        }
+
+        /// @brief 本线程的缓冲区，指针没有析构函数，热路径只需一次线程局部读取
+        static StagingBuffer *&cached() {
+            thread_local StagingBuffer *value = nullptr;
+            return value;
+        }
+
+        /// @brief 本线程的 owner 已析构，之后其他 thread_local 析构中的日志不能再用缓冲区
+        ///
+        /// bool 没有析构函数，在线程退出的析构阶段仍然可以访问。
+        static bool &exited() {
+            thread_local bool value = false;
+            return value;
+        }
+    };
+
+   public:
+    static DeferredLogger &instance() {
+        static DeferredLogger *_inst = new DeferredLogger;
+        return *_inst;
+    }
+
+    /// @brief 开启延迟格式化输出
+    void start() {
+        std::lock_guard guard(mtx_);
+        if (writer_.joinable()) {
+            return;
+        }
+        //< 单调时间到墙上时间的偏移，后台线程换算时间戳使用
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        realtime_offset_ = ts.tv_sec * 1000ull * 1000 * 1000 + ts.tv_nsec - now_ns();
+        use_tsc_.store(TscClock::instance().enabled(), std::memory_order_relaxed);
+        exit_ = false;
+        writer_ = std::thread(&DeferredLogger::on_write, this);
+        if (!atexit_registered_) {
+            atexit_registered_ = true;
+            std::atexit([]() { DeferredLogger::instance().stop(); });
+        }
+        LogConfig::mode = kLogDeferred;
+    }
+
+    /// @brief 关闭延迟格式化输出，写完已记录的日志后返回
+    void stop() {
+        std::lock_guard guard(mtx_);
+        if (!writer_.joinable()) {
+            return;
+        }
+        int mode = kLogDeferred;
+        LogConfig::mode.compare_exchange_strong(mode, kLogSync);
+        exit_ = true;
+        writer_.join();
+    }
+
+    template <typename... Args>
+    static bool log(const LogSite *site, const Args &...args) {
+        return log_with<LogArgs<log_arg_t<Args>...>>(site, args...);
+    }
+
+    /// @brief 按 Codec 编码参数，Codec::format 在后台线程还原并格式化
+    /// @return 本线程已经退出、缓冲区已交给后台线程释放时返回 false，调用者改为同步输出
+    template <typename Codec, typename... Args>
+    static bool log_with(const LogSite *site, const Args &...args) {
+        auto buffer = local_buffer();
+        if (!buffer) {
+            return false;
+        }
+        auto size = (sizeof(Header) + Codec::size(args...) + 7) & ~size_t(7);
+        auto out = size < StagingBuffer::kSize ? buffer->reserve(size) : nullptr;
+        if (!out) {
+            buffer->dropped_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        auto tsc = use_tsc_.load(std::memory_order_relaxed);
+        Header header{(uint32_t)size, tsc, site, &Codec::format,
+                      tsc ? TscClock::ticks() : SteadyClock::read()};
+        memcpy(out, &header, sizeof(header));
+        Codec::encode(out + sizeof(header), args...);
+        buffer->commit(size);
+        return true;
+    }
+
+   private:
+    DeferredLogger() = default;
+
+    static uint64_t now_ns() { return TscClock::instance().now_ns(); }
+
+    static StagingBuffer *local_buffer() {
+        if (auto buffer = BufferOwner::cached()) {
+            return buffer;
+        }
+        if (BufferOwner::exited()) {
+            return nullptr;
+        }
+        thread_local BufferOwner owner;
+        if (!owner.buffer) {
+            owner.buffer = instance().register_buffer();
+        }
+        BufferOwner::cached() = owner.buffer;
+        return owner.buffer;
+    }
+
+    StagingBuffer *register_buffer() {
+        std::lock_guard guard(buffers_mtx_);
+        buffers_.emplace_back(new StagingBuffer);
+        return buffers_.back().get();
+    }
+
+    void on_write() {
+        std::vector<StagingBuffer *> buffers;
+        while (true) {
+            {
+                std::lock_guard guard(buffers_mtx_);
+                buffers.clear();
+                for (auto &buffer : buffers_) {
+                    buffers.push_back(buffer.get());
+                }
+            }
+
+            auto count = 0u;
+            for (auto buffer : buffers) {
+                count += drain(*buffer);
+            }
+            batch_.flush();
+            release_retired();
+
+            if (count == 0) {
+                if (exit_) {
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(kPollMs));
+            }
+        }
+    }
+
+    unsigned drain(StagingBuffer &buffer) {
+        auto count = 0u;
+        auto tail = buffer.tail_.load(std::memory_order_relaxed);
+        auto head = buffer.head_.load(std::memory_order_acquire);
+        while (tail != head) {
+            auto pos = tail % StagingBuffer::kSize;
+            Header header;
+            memcpy(&header, buffer.data_ + pos, sizeof(header.size));
+            if (header.size == 0) {
+                tail += StagingBuffer::kSize - pos;
+                continue;
+            }
+            memcpy(&header, buffer.data_ + pos, sizeof(header));
+
+            auto raw = log_time_raw();
+            auto ns = header.tsc ? TscClock::instance().to_ns(header.ns) : header.ns;
+            ns = raw ? ns : ns + realtime_offset_;
+            auto args = buffer.data_ + pos + sizeof(header);
+            batch_.append(ns, raw, *header.site, [&](char *out, size_t size) {
+                return header.format(*header.site, args, out, size);
+            });
+            tail += header.size;
+            ++count;
+        }
+        buffer.tail_.store(tail, std::memory_order_release);
+        batch_.report_dropped(buffer.dropped_.exchange(0, std::memory_order_relaxed));
+        return count;
+    }
+
+    /// @brief 释放所属线程已退出且已读完的缓冲区
+    void release_retired() {
+        std::lock_guard guard(buffers_mtx_);
+        buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+                                      [](const std::unique_ptr<StagingBuffer> &buffer) {
+                                          return buffer->retired_.load(std::memory_order_acquire) &&
+                                                 buffer->tail_.load() == buffer->head_.load();
+                                      }),
+                       buffers_.end());
+    }
+
+   private:
+    std::mutex mtx_;
+    std::thread writer_;
+    std::atomic<bool> exit_{false};
+    bool atexit_registered_ = false;
+    uint64_t realtime_offset_ = 0;
+    static inline std::atomic<bool> use_tsc_{false};  //< 调用线程只读 TSC，由后台线程换算
+    std::mutex buffers_mtx_;
+    std::vector<std::unique_ptr<StagingBuffer>> buffers_;
+    LogBatch batch_;  //< 只由后台线程访问
+};
+
+/// @brief 飞行记录器
+///
+/// sl_* 把 record_level 以内的调用点指针、时间戳和参数原始字节写入线程私有的环形数组，
+/// 不格式化也没有锁，代价与 DeferredLogger 相当。record_level 默认为 Debug，所有日志都会记录，
+/// 崩溃前的细节不依赖运行时级别；对热路径敏感时用 set_record_level 收紧，或用 follow_record_level
+/// 跟随运行时级别，被过滤的日志不求值参数也不记录。每个线程保留最近
+/// STROLL_FLIGHT_RECORDER_SLOTS 条，参数超过单条容量时只记录调用点。
+/// 支持 invariant TSC 时时间戳只读 TSC，转储时以当时的 TSC 和单调时间为基准换算。
+/// install_crash_handler 之后，进程收到致命信号时按线程把记录写入文件，
+/// 转储只使用 open/write 和不依赖 printf 的格式化，是异步信号安全的。
+/// 每条记录写入时先把序号清零、写完再发布，转储时序号前后不一致的记录被跳过。
+class FlightRecorder {
+    static const size_t kSlots = STROLL_FLIGHT_RECORDER_SLOTS;
+    static const uint32_t kNoArgs = UINT32_MAX;
+    static constexpr int kSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> seq{0};  //< 写入中为0，写完为序号加1
+        uint64_t stamp;                //< use_tsc_ 时为 TSC，否则为单调时间
+        const LogSite *site;
+        void (*dump)(const LogSite &, const char *, LogSafeWriter &);
+        uint32_t size;  //< 参数字节数
+        uint32_t tid;   //< 记录环会被新线程复用，按条记录所属线程
+        char args[88];
+    };
+    static_assert(sizeof(Slot) == 128, "flight recorder slot must be 128 bytes");
+
+    struct Ring {
+        Slot slots[kSlots];
+        std::atomic<uint64_t> head{0};
+        std::atomic<bool> owned{true};
+        uint32_t tid = 0;
+        Ring *next = nullptr;  //< 发布后不再修改
+    };
+
+    /// @brief 线程退出时归还记录环，内容保留到被新线程覆盖
+    struct RingOwner {
+        Ring *ring = nullptr;
+        ~RingOwner() {
+            if (ring) {
+                ring->owned.store(false, std::memory_order_release);
+            }
+            ring = nullptr;
+            cached() = nullptr;
+            exited() = true;
+        }
+
+        /// @brief 本线程的记录环，指针没有析构函数，热路径只需一次线程局部读取
+        static Ring *&cached() {
+            thread_local Ring *value = nullptr;
+            return value;
+        }
+
+        /// @brief 本线程的 owner 已析构，之后的记录不能再写入已归还的记录环
+        static bool &exited() {
+            thread_local bool value = false;
+            return value;
+        }
+    };
+
+   public:
+    static bool enabled(LogLevel level) {
+        return STROLL_FLIGHT_RECORDER && level <= log_record_level();
+    }
+
+    template <typename... Args>
+    static void record(const LogSite *site, const Args &...args) {
+        record_with<LogArgs<log_arg_t<Args>...>>(site, args...);
+    }
+
+    /// @brief 按 Codec 编码参数，Codec::dump 在转储时还原并格式化
+    template <typename Codec, typename... Args>
+    static void record_with(const LogSite *site, const Args &...args) {
+        auto ring = local_ring();
+        if (!ring) {
+            return;
+        }
+        auto index = ring->head.load(std::memory_order_relaxed);
+        auto &slot = ring->slots[index % kSlots];
+
+        slot.seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.stamp = use_tsc_ ? TscClock::ticks() : SteadyClock::read();
+        slot.site = site;
+        slot.dump = &Codec::dump;
+        slot.tid = ring->tid;
+        auto size = Codec::size(args...);
+        if (size <= sizeof(slot.args)) {
+            Codec::encode(slot.args, args...);
+            slot.size = size;
+        } else {
+            slot.size = kNoArgs;
+        }
+        slot.seq.store(index + 1, std::memory_order_release);
+        ring->head.store(index + 1, std::memory_order_release);
+    }
+
+    /// @brief 把所有线程的记录写到 fd，每个线程内按时间顺序，异步信号安全
+    static void dump(int fd) {
+        LogSafeWriter out(fd);
+        out.put("==== flight recorder, now ");
+        put_time(out, SteadyClock::read());
+        out.put(" ====\n");
+        Anchor now{TscClock::ticks(), SteadyClock::read()};
+        for (auto ring = rings_.load(std::memory_order_acquire); ring; ring = ring->next) {
+            uint32_t tid = 0;
+            auto head = ring->head.load(std::memory_order_acquire);
+            for (auto i = head > kSlots ? head - kSlots : 0; i < head; ++i) {
+                dump_slot(out, ring->slots[i % kSlots], i + 1, now, tid);
+            }
+        }
+    }
+
+    /// @brief 收到 SIGSEGV、SIGBUS、SIGFPE、SIGILL、SIGABRT 时把记录写入 path，
+    /// 之后恢复原来的处理方式并重新触发信号
+    static void install_crash_handler(const char *path) {
+        snprintf(crash_path_, sizeof(crash_path_), "%s", path);
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = &FlightRecorder::on_crash;
+        sigemptyset(&action.sa_mask);
+        for (auto i = 0u; i < std::size(kSignals); ++i) {
+            sigaction(kSignals[i], &action, &old_actions_[i]);
+        }
+    }
+
+   private:
+    /// @brief 同一时刻读到的 TSC 和单调时间
+    struct Anchor {
+        uint64_t tsc;
+        uint64_t ns;
+    };
+
+    static Ring *local_ring() {
+        if (auto ring = RingOwner::cached()) {
+            return ring;
+        }
+        if (RingOwner::exited()) {
+            return nullptr;
+        }
+        thread_local RingOwner owner;
+        if (!owner.ring) {
+            owner.ring = acquire_ring();
+        }
+        RingOwner::cached() = owner.ring;
+        return owner.ring;
+    }
+
+    /// @brief 优先复用已退出线程的记录环，没有时分配并挂到全局链表头
+    static Ring *acquire_ring() {
+        //< 第一个记录环创建前确定时间戳来源并记下起点，之后不再改变
+        static std::once_flag once;
+        std::call_once(once, []() {
+            start_ = {TscClock::ticks(), SteadyClock::read()};
+            use_tsc_ = TscClock::supported();
+        });
+
+        auto tid = syscall(SYS_gettid);
+        for (auto ring = rings_.load(std::memory_order_acquire); ring; ring = ring->next) {
+            bool expected = false;
+            if (!ring->owned.load() && ring->owned.compare_exchange_strong(expected, true)) {
+                ring->tid = tid;
+                return ring;
+            }
+        }
+        auto ring = new Ring;
+        ring->tid = tid;
+        ring->next = rings_.load();
+        while (!rings_.compare_exchange_weak(ring->next, ring)) {
+        }
+        return ring;
+    }
+
+    /// @brief 把记录的时间戳换算为单调时间
+    ///
+    /// 频率取起点到 now 的平均值，从 now 往回推，只读 TSC 和 clock_gettime，异步信号安全。
+    /// 记录都是最近写入的，回推的跨度短，误差很小。
+    static uint64_t stamp_ns(uint64_t stamp, const Anchor &now) {
+        if (!use_tsc_) {
+            return stamp;
+        }
+        if (stamp >= now.tsc || now.tsc <= start_.tsc) {
+            return now.ns;
+        }
+        auto ticks = now.tsc - stamp;
+        auto back = (uint64_t)((unsigned __int128)ticks * (now.ns - start_.ns) / (now.tsc - start_.tsc));
+        return now.ns - std::min(back, now.ns);
+    }
+
+    static void put_time(LogSafeWriter &out, uint64_t ns) {
+        char digits[9];
+        out.put_uint(ns / 1000000000);
+        out.put('.');
+        log_put_digits(digits, ns % 1000000000, sizeof(digits));
+        for (auto c : digits) {
+            out.put(c);
+        }
+    }
+
+    /// @brief 输出一条记录，所属线程与上一条不同时先输出线程标题
+    static void dump_slot(LogSafeWriter &out, const Slot &slot, uint64_t seq, const Anchor &now,
+                          uint32_t &tid) {
+        if (slot.seq.load(std::memory_order_acquire) != seq) {
+            return;
+        }
+        auto stamp = slot.stamp;
+        auto site = slot.site;
+        auto dump = slot.dump;
+        auto size = slot.size;
+        auto owner = slot.tid;
+        char args[sizeof(slot.args)];
+        memcpy(args, slot.args, std::min<size_t>(size, sizeof(args)));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq) {
+            return;
+        }
+
+        if (owner != tid) {
+            tid = owner;
+            out.put("---- thread ");
+            out.put_uint(tid);
+            out.put(" ----\n");
+        }
+        out.put('[');
+        put_time(out, stamp_ns(stamp, now));
+        out.put("][");
+        out.put(site->tag);
+        out.put("][");
+        out.put(level_text[site->level]);
+        out.put("][");
+        out.put(site->file);
+        out.put(':');
+        out.put(site->func);
+        out.put(':');
+        out.put_uint(site->line);
+        out.put("] ");
+        if (size == kNoArgs) {
+            out.put(site->fmt);
+        } else {
+            dump(*site, args, out);
+        }
+        out.end_line();
+    }
+
+    static void on_crash(int sig) {
+        //< 多个线程同时崩溃时只转储一次
+        if (!crashed_.exchange(true)) {
+            auto fd = ::open(crash_path_, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd >= 0) {
+                {
+                    LogSafeWriter out(fd);
+                    out.put("signal ");
+                    out.put_uint(sig);
+                    out.put(" on thread ");
+                    out.put_uint(syscall(SYS_gettid));
+                    out.put('\n');
+                }
+                dump(fd);
+                ::close(fd);
+            }
+        }
+        for (auto i = 0u; i < std::size(kSignals); ++i) {
+            if (kSignals[i] == sig) {
+                sigaction(sig, &old_actions_[i], nullptr);
+            }
+        }
+        raise(sig);
+    }
+
+   private:
+    static inline std::atomic<Ring *> rings_{nullptr};
+    static inline std::atomic<bool> crashed_{false};
+    static inline Anchor start_{0, 0};  //< 第一个记录环创建时的起点
+    static inline bool use_tsc_ = false;  //< 由 call_once 写入，之后只读
+    static inline char crash_path_[256];
+    static inline struct sigaction old_actions_[std::size(kSignals)];
+};
+
+/// @brief 飞行记录器的级别，比 level 更详细的日志不再记录，可以比运行时级别更详细
+static inline void set_record_level(LogLevel level) {
+    LogConfig::record_level.store(level);
+    log_update_active_level();
+}
+
+/// @brief 飞行记录器跟随运行时日志级别，被输出过滤的日志也不再记录，省去它们的记录开销
+static inline void follow_record_level() {
+    LogConfig::record_level.store(LogConfig::kFollowLevel);
+    log_update_active_level();
+}
+
+/// @brief 飞行记录器恢复默认的 Debug 级别，记录所有日志
+static inline void reset_record_level() {
+    LogConfig::record_level.store(kDebug);
+    log_update_active_level();
+}
+
+/// @brief 在调用线程上格式化并输出，整行拼好后一次写出，避免多线程输出交错
+static inline void log_sync(const LogSite *site, ...) {
+    char line[1024];
+    auto raw = log_time_raw();
+    auto reset = log_color(NORAL_TEXT_COLOR);
+    auto reset_len = strlen(reset);
+    auto prefix = snprintf(line, sizeof(line), "%s[%s][%s][%s][%s:%s:%d] ", log_color(site->color),
+                           log_time_text(log_now_ns(raw), raw), site->tag, level_text[site->level],
+                           site->file, site->func, site->line);
+    prefix = std::min<int>(std::max(prefix, 0), sizeof(line) - 1);
+
+    va_list args;
+    va_start(args, site);
+    auto body = vsnprintf(line + prefix, sizeof(line) - prefix, site->fmt, args);
+    va_end(args);
+
+    size_t size = prefix + std::max(body, 0);
+    if (size + reset_len < sizeof(line)) {
+        memcpy(line + size, reset, reset_len);
+        log_write(line, size + reset_len);
+        return;
+    }
+
+    //< 超长的日志在堆上重新格式化
+    std::unique_ptr<char[]> heap(new char[size + reset_len + 1]);
+    memcpy(heap.get(), line, prefix);
+    va_start(args, site);
+    vsnprintf(heap.get() + prefix, size - prefix + 1, site->fmt, args);
+    va_end(args);
+    memcpy(heap.get() + size, reset, reset_len);
+    log_write(heap.get(), size + reset_len);
+}
+
+/// @brief 写入飞行记录器，output 为 true 时再按当前方式输出，参数只在 sl_* 中求值一次
+template <typename... Args>
+static inline void log_emit(const LogSite *site, bool output, const Args &...args) {
+    if (FlightRecorder::enabled(site->level)) {
+        FlightRecorder::record(site, args...);
+    }
+    if (!output) {
+        return;
+    }
+    switch (log_mode()) {
+        case kLogDeferred:
+            if (!DeferredLogger::log(site, args...)) {
+                log_sync(site, args...);
+            }
+            break;
+        case kLogAsync:
+            AsyncLogger::instance().log(site, args...);
+            break;
+        default:
+            log_sync(site, args...);
+            break;
+    }
+}
+
+/// @brief 写入日志前缀，与 log_sync 的格式相同，不经过 printf
+static inline void log_fmt_prefix(LogFmtBuffer &out, const LogSite &site, uint64_t ns, bool raw) {
+    char text[16];
+    auto end = text + sizeof(text);
+    auto line = log_fmt_uint(end, site.line, 10);
+    out.put(log_color(site.color));
+    out.put('[');
+    out.put(log_time_text(ns, raw));
+    out.put("][");
+    out.put(site.tag);
+    out.put("][");
+    out.put(level_text[site.level]);
+    out.put("][");
+    out.put(site.file);
+    out.put(':');
+    out.put(site.func);
+    out.put(':');
+    out.put(line, end - line);
+    out.put("] ");
+}
+
+/// @brief slf_* 的同步输出，整行在栈上拼好后一次写出，超长时在堆上重新格式化
+template <typename... Args>
+static inline void log_fmt_sync(const LogSite *site, const Args &...args) {
+    auto raw = log_time_raw();
+    auto ns = log_now_ns(raw);
+    auto format = [&](char *data, size_t size) {
+        LogFmtBuffer out(data, size);
+        log_fmt_prefix(out, *site, ns, raw);
+        log_fmt_write(out, *site->spec, site->fmt, args...);
+        out.put(log_color(NORAL_TEXT_COLOR));
+        return out;
+    };
+
+    char line[1024];
+    auto out = format(line, sizeof(line));
+    if (out.needed() <= sizeof(line)) {
+        log_write(line, out.size());
+        return;
+    }
+    std::unique_ptr<char[]> heap(new char[out.needed()]);
+    log_write(heap.get(), format(heap.get(), out.needed()).size());
+}
+
+/// @brief slf_* 的输出：与 log_emit 相同，只是各后端都按编译期解析的格式串格式化
+template <typename... Args>
+static inline void log_fmt_emit(const LogSite *site, bool output, const Args &...args) {
+    using Codec = LogFmtArgs<log_fmt_arg_t<Args>...>;
+    if (FlightRecorder::enabled(site->level)) {
+        FlightRecorder::record_with<Codec>(site, args...);
+    }
+    if (!output) {
+        return;
+    }
+    switch (log_mode()) {
+        case kLogDeferred:
+            if (!DeferredLogger::log_with<Codec>(site, args...)) {
+                log_fmt_sync(site, args...);
+            }
+            break;
+        case kLogAsync:
+            AsyncLogger::instance().write(site, [&](char *data, size_t size) {
+                LogFmtBuffer out(data, size);
+                log_fmt_write(out, *site->spec, site->fmt, args...);
+                return (int)out.needed();
+            });
+            break;
+        default:
+            log_fmt_sync(site, args...);
+            break;
     }
-    return file_name[index] == PATH_SEP ? file_name + index + 1 : file_name;
 }
 
 #define TRACE_INFO(COLOR, TAG, LEVEL, FMT, args...)                                              \
     do {                                                                                         \
-        struct timespec ts;                                                                      \
-        clock_gettime(CLOCK_REALTIME, &ts);                                                      \
-        struct tm datetime;                                                                      \
-        localtime_r(&ts.tv_sec, &datetime);                                                      \
-        std::printf(                                                                             \
-            COLOR                                                                                \
-            "[%04d-%02d-%02d %02d:%02d:%02d.%03d][%s][%s][%s:%s:%d] " FMT NORAL_TEXT_COLOR,      \
-            datetime.tm_year + 1900, datetime.tm_mon + 1, datetime.tm_mday, datetime.tm_hour,    \
-            datetime.tm_min, datetime.tm_sec, (int)(ts.tv_nsec / 1000 / 1000), (TAG),            \
-            level_text[(LEVEL)], log_base_file_name(__FILE__), __func__, __LINE__, ##args);      \
+        if (!stroll::log_active(LEVEL)) {                                                        \
+            break;                                                                               \
+        }                                                                                        \
+        auto _sl_output = stroll::log_enabled(LEVEL);                                            \
+        static const stroll::LogSite _sl_site = {                                                \
+            COLOR, (TAG), (LEVEL), SL_FILE_NAME, __func__, __LINE__, FMT};                       \
+        /* 只用来做编译期格式检查，不会执行 */                                 \
+        if (false) {                                                                             \
+            std::printf(FMT, ##args);                                                            \
+        }                                                                                        \
+        stroll::log_emit(&_sl_site, _sl_output, ##args);                                         \
+    } while (0)
+
+/// @brief 只写入飞行记录器的事件，不输出，用于记录高频的内部事件
+#define sl_record(fmt, args...)                                                                  \
+    do {                                                                                         \
+        if (!stroll::FlightRecorder::enabled(stroll::kDebug)) {                                  \
+            break;                                                                               \
+        }                                                                                        \
+        static const stroll::LogSite _sl_site = {                                                \
+            "", TAG, stroll::kDebug, SL_FILE_NAME, __func__, __LINE__, fmt};                     \
+        if (false) {                                                                             \
+            std::printf(fmt, ##args);                                                            \
+        }                                                                                        \
+        stroll::FlightRecorder::record(&_sl_site, ##args);                                       \
+    } while (0)
+
+/// @brief 单个调用点的限流状态，限流日志宏在每个调用处各有一份静态实例
+///
+/// 只有原子操作，没有全局锁；被丢弃的调用不求值参数，放行时返回此前被丢弃的次数。
+class LogLimiter {
+   public:
+    /// @brief 每 n 次放行一次，n 为0时不限流
+    bool every_n(uint64_t n, uint64_t &suppressed) {
+        if (n == 0) {
+            return true;
+        }
+        auto count = count_.fetch_add(1, std::memory_order_relaxed);
+        if (count % n != 0) {
+            return false;
+        }
+        suppressed = count == 0 ? 0 : n - 1;
+        return true;
+    }
+
+    /// @brief 每 ms 毫秒最多放行一次，ms 为0时不限流
+    bool every_ms(uint64_t ms, uint64_t &suppressed) {
+        if (ms == 0) {
+            return true;
+        }
+        auto now = SteadyClock::read();
+        auto next = next_ns_.load(std::memory_order_relaxed);
+        if (now < next || !next_ns_.compare_exchange_strong(next, now + ms * 1000 * 1000,
+                                                            std::memory_order_relaxed)) {
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    /// @brief 按 1/n 的概率随机放行，n 为0时不限流
+    bool sampled(uint64_t n, uint64_t &suppressed) {
+        if (n == 0) {
+            return true;
+        }
+        thread_local uint64_t state = reinterpret_cast<uintptr_t>(&state) | 1;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        if (state % n != 0) {
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+   private:
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> next_ns_{0};
+    std::atomic<uint64_t> suppressed_{0};
+};
+
+/// @brief 限流输出，POLICY 为 LogLimiter 的成员函数，之前有被丢弃的日志时在行首注明次数
+#define SL_LOG_LIMITED(COLOR, LEVEL, POLICY, ARG, FMT, args...)                                  \
+    do {                                                                                         \
+        if (!stroll::log_active(LEVEL)) {                                                        \
+            break;                                                                               \
+        }                                                                                        \
+        static stroll::LogLimiter _sl_limiter;                                                   \
+        uint64_t _sl_suppressed = 0;                                                             \
+        if (!_sl_limiter.POLICY((ARG), _sl_suppressed)) {                                        \
+            break;                                                                               \
+        }                                                                                        \
+        if (_sl_suppressed == 0) {                                                               \
+            TRACE_INFO(COLOR, TAG, LEVEL, FMT, ##args);                                          \
+        } else {                                                                                 \
+            TRACE_INFO(COLOR, TAG, LEVEL, "[%" PRIu64 " suppressed] " FMT, _sl_suppressed,       \
+                       ##args);                                                                  \
+        }                                                                                        \
+    } while (0)
+
+/// @brief fmt 风格的日志，格式串用 {} 占位，在编译期解析并按参数类型检查，
+/// 运行时按类型直接格式化，不解析格式串也不经过 vsnprintf
+#define TRACE_FMT(COLOR, TAG, LEVEL, FMT, args...)                                               \
+    do {                                                                                         \
+        static constexpr stroll::LogFmtSpec _sl_spec = stroll::LogFmtSpec::parse(FMT);           \
+        static_assert(                                                                           \
+            stroll::LogFmtChecker<decltype(std::forward_as_tuple(args))>::check(_sl_spec),       \
+            "format string does not match the arguments");                                      \
+        if (!stroll::log_active(LEVEL)) {                                                        \
+            break;                                                                               \
+        }                                                                                        \
+        auto _sl_output = stroll::log_enabled(LEVEL);                                            \
+        static const stroll::LogSite _sl_site = {                                                \
+            COLOR, (TAG), (LEVEL), SL_FILE_NAME, __func__, __LINE__, FMT, &_sl_spec};            \
+        stroll::log_fmt_emit(&_sl_site, _sl_output, ##args);                                     \
+    } while (0)
+
+/// @brief 被编译期级别移除的日志，保留格式检查，参数不会求值
+#define SL_LOG_DISABLED(fmt, args...)    \
+    do {                                 \
+        if (false) {                     \
+            std::printf(fmt, ##args);    \
+        }                                \
+    } while (0)
+
+/// @brief 被编译期级别移除的 slf_*，保留格式检查，参数不会求值
+#define SLF_LOG_DISABLED(fmt, args...)                                                           \
+    do {                                                                                         \
+        static constexpr stroll::LogFmtSpec _sl_spec = stroll::LogFmtSpec::parse(fmt);           \
+        static_assert(                                                                           \
+            stroll::LogFmtChecker<decltype(std::forward_as_tuple(args))>::check(_sl_spec),       \
+            "format string does not match the arguments");                                      \
     } while (0)
 
-#define sl_error(fmt, args...) TRACE_INFO(ERROR_TEXT_COLOR, TAG, kError, fmt, ##args)
+#if STROLL_LOG_MIN_LEVEL >= 0
+#define sl_error(fmt, args...) TRACE_INFO(ERROR_TEXT_COLOR, TAG, stroll::kError, fmt, ##args)
+#define slf_error(fmt, args...) TRACE_FMT(ERROR_TEXT_COLOR, TAG, stroll::kError, fmt, ##args)
+#else
+#define sl_error(fmt, args...) SL_LOG_DISABLED(fmt, ##args)
+#define slf_error(fmt, args...) SLF_LOG_DISABLED(fmt, ##args)
+#endif
 
-#define sl_warn(fmt, args...) TRACE_INFO(WARN_TEXT_COLOR, TAG, kWarn, fmt, ##args)
+#if STROLL_LOG_MIN_LEVEL >= 1
+#define sl_warn(fmt, args...) TRACE_INFO(WARN_TEXT_COLOR, TAG, stroll::kWarn, fmt, ##args)
+#define slf_warn(fmt, args...) TRACE_FMT(WARN_TEXT_COLOR, TAG, stroll::kWarn, fmt, ##args)
+/// @brief 该调用处每 n 次输出一次，n 为0时每次都输出
+#define sl_warn_every_n(n, fmt, args...) \
+    SL_LOG_LIMITED(WARN_TEXT_COLOR, stroll::kWarn, every_n, n, fmt, ##args)
+/// @brief 该调用处每 ms 毫秒最多输出一次，ms 为0时每次都输出
+#define sl_warn_every_ms(ms, fmt, args...) \
+    SL_LOG_LIMITED(WARN_TEXT_COLOR, stroll::kWarn, every_ms, ms, fmt, ##args)
+/// @brief 该调用处按 1/n 的概率随机输出，n 为0时每次都输出
+#define sl_warn_sampled(n, fmt, args...) \
+    SL_LOG_LIMITED(WARN_TEXT_COLOR, stroll::kWarn, sampled, n, fmt, ##args)
+#else
+#define sl_warn(fmt, args...) SL_LOG_DISABLED(fmt, ##args)
+#define slf_warn(fmt, args...) SLF_LOG_DISABLED(fmt, ##args)
+#define sl_warn_every_n(n, fmt, args...) SL_LOG_DISABLED(fmt, ##args)
+#define sl_warn_every_ms(ms, fmt, args...) SL_LOG_DISABLED(fmt, ##args)
+#define sl_warn_sampled(n, fmt, args...) SL_LOG_DISABLED(fmt, ##args)
+#endif
 
-#define sl_info(fmt, args...) TRACE_INFO(INFO_TEXT_COLOR, TAG, kInfo, fmt, ##args)
+#if STROLL_LOG_MIN_LEVEL >= 2
+#define sl_info(fmt, args...) TRACE_INFO(INFO_TEXT_COLOR, TAG, stroll::kInfo, fmt, ##args)
+#define slf_info(fmt, args...) TRACE_FMT(INFO_TEXT_COLOR, TAG, stroll::kInfo, fmt, ##args)
+#else
+#define sl_info(fmt, args...) SL_LOG_DISABLED(fmt, ##args)
+#define slf_info(fmt, args...) SLF_LOG_DISABLED(fmt, ##args)
+#endif
 
-#define sl_debug(fmt, args...) TRACE_INFO(DEBUG_TEXT_COLOR, TAG, kDebug, fmt, ##args)
+#if STROLL_LOG_MIN_LEVEL >= 3
+#define sl_debug(fmt, args...) TRACE_INFO(DEBUG_TEXT_COLOR, TAG, stroll::kDebug, fmt, ##args)
+#define slf_debug(fmt, args...) TRACE_FMT(DEBUG_TEXT_COLOR, TAG, stroll::kDebug, fmt, ##args)
+#else
+#define sl_debug(fmt, args...) SL_LOG_DISABLED(fmt, ##args)
+#define slf_debug(fmt, args...) SLF_LOG_DISABLED(fmt, ##args)
+#endif
 
 }  // namespace stroll
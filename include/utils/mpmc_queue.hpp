@@ -0,0 +1,98 @@
+/**
+ * @file mpmc_queue.hpp
+ * @author stroll (116356647@qq.com)
+ * @brief 有界无锁多生产者多消费者队列
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace stroll {
+
+/// @brief 有界无锁 MPMC 队列(Vyukov)
+///
+/// 每个槽位带一个序号，生产者和消费者各自只 CAS 一次位置计数，
+/// 通过槽位序号判断槽位是否可写或可读，不需要额外的锁和节点分配。
+template <typename T>
+class MpmcQueue {
+    struct Cell {
+        std::atomic<size_t> seq;
+        T data;
+    };
+
+   public:
+    /// @param capacity 容量，向上取整为2的幂
+    explicit MpmcQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask_ = size - 1;
+        cells_.reset(new Cell[size]);
+        for (size_t i = 0; i < size; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcQueue(const MpmcQueue &) = delete;
+    MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+    /// @return 队列已满时返回 false
+    bool push(const T &value) {
+        auto pos = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            auto &cell = cells_[pos & mask_];
+            auto seq = cell.seq.load(std::memory_order_acquire);
+            auto diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = value;
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// @return 队列为空时返回 false
+    bool pop(T &value) {
+        auto pos = head_.load(std::memory_order_relaxed);
+        while (true) {
+            auto &cell = cells_[pos & mask_];
+            auto seq = cell.seq.load(std::memory_order_acquire);
+            auto diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = cell.data;
+                    cell.seq.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+   private:
+    size_t mask_ = 0;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+}  // namespace stroll
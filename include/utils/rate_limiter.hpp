@@ -0,0 +1,190 @@
+/**
+ * @file rate_limiter.hpp
+ * @author stroll (116356647@qq.com)
+ * @brief 令牌桶限流器
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "utils/clock.hpp"
+#include "utils/timer.hpp"
+
+namespace stroll {
+
+/// @brief 限流等待队列，所有限流器阻塞等待的线程共用一个定时器唤醒
+///
+/// 等待者按各自算出的可重试时间排序，共享定时器只在队首的可重试时间触发，
+/// 唤醒已经到期的等待者后按新的队首设置下次延迟，没有等待者时停止；
+/// 插入比当前计划更早的等待者时重新启动定时器。不论多少个限流器都只占用一个堆节点。
+/// 可重试时间在 steady_clock 时间轴上，非虚拟时钟源与之一致。
+class RateLimitWaiter {
+    struct Waiter {
+        std::condition_variable cond;
+        bool woken = false;
+    };
+
+   public:
+    static RateLimitWaiter &instance() {
+        static RateLimitWaiter _inst;
+        return _inst;
+    }
+
+    /// @brief 阻塞直到 pred 返回 true
+    /// @param clock 限流器的时钟源，不能是虚拟时钟
+    /// @param pred 重试条件，在内部锁内调用
+    /// @param delay pred 失败后还需等待的时间，按 clock 计算，单位为ns，到期前不会被唤醒
+    void wait(ClockSource &clock, const std::function<bool()> &pred,
+              const std::function<uint64_t()> &delay) {
+        std::unique_lock lock(mtx_);
+        Waiter self;
+        while (!pred()) {
+            auto tp = align_to_tick(clock.now_ns() + delay());
+            waiters_.emplace(tp, &self);
+            if (tp < armed_tp_) {
+                armed_tp_ = tp;
+                timer_.start(std::chrono::milliseconds(delay_ms(tp, SteadyClock::read())));
+            }
+            self.cond.wait(lock, [&self]() { return self.woken; });
+            self.woken = false;
+        }
+    }
+
+    /// @brief 设置唤醒粒度，可重试时间向上对齐到 tick，同一 tick 内到期的等待者合并为一次唤醒
+    /// @param ms 为0时不对齐
+    void set_tick(unsigned ms) {
+        std::lock_guard guard(mtx_);
+        tick_ns_ = 1000ull * 1000 * ms;
+    }
+
+   private:
+    RateLimitWaiter() : timer_("rate_limit_waiter", [this]() -> int64_t { return wakeup(); }) {}
+
+    /// @brief 唤醒到期的等待者
+    /// @return 到下一个等待者的延迟，没有等待者时停止定时器
+    int64_t wakeup() {
+        std::lock_guard guard(mtx_);
+        auto now = SteadyClock::read();
+        while (!waiters_.empty() && waiters_.begin()->first <= now) {
+            auto waiter = waiters_.begin()->second;
+            waiters_.erase(waiters_.begin());
+            waiter->woken = true;
+            waiter->cond.notify_one();
+        }
+        if (waiters_.empty()) {
+            armed_tp_ = kNotArmed;
+            return kTimerStop;
+        }
+        armed_tp_ = waiters_.begin()->first;
+        return delay_ms(armed_tp_, now);
+    }
+
+    /// @brief 需要持有 mtx_
+    uint64_t align_to_tick(uint64_t tp) const {
+        return tick_ns_ == 0 ? tp : (tp + tick_ns_ - 1) / tick_ns_ * tick_ns_;
+    }
+
+    /// @brief 定时器精度为ms，向上取整保证触发时已经到期
+    static int64_t delay_ms(uint64_t tp, uint64_t now) {
+        static const uint64_t kNsPerMs = 1000ull * 1000;
+        return tp > now ? (tp - now + kNsPerMs - 1) / kNsPerMs : 0;
+    }
+
+   private:
+    static const uint64_t kNotArmed = ~0ull;
+
+    std::mutex mtx_;
+    std::multimap<uint64_t, Waiter *> waiters_;  //< 按可重试时间排序的等待者
+    uint64_t armed_tp_ = kNotArmed;              //< 共享定时器计划触发的时间
+    uint64_t tick_ns_ = 1000ull * 1000;
+    Timer timer_;
+};
+
+/// @brief 令牌桶限流器
+///
+/// 按 GCRA 实现：只维护一个"理论到达时间" tat，令牌的补充由时钟推算，
+/// 不需要为每个桶注册补充定时器。try_acquire 只有一次 CAS，无锁。
+/// 每个桶只占几个字节，可以按租户大量创建。
+class TokenBucket {
+   public:
+    /// @brief 构造一个令牌桶
+    /// @param rate 每秒补充的令牌数
+    /// @param burst 桶容量，即允许的最大突发
+    /// @param clock 时钟源
+    TokenBucket(double rate, uint32_t burst, ClockSource &clock = SteadyClock::instance())
+        : emission_ns_(std::max<uint64_t>(1, (uint64_t)(1e9 / rate))),
+          tolerance_ns_(emission_ns_ * burst),
+          clock_(&clock) {}
+
+    TokenBucket(const TokenBucket &) = delete;
+    TokenBucket &operator=(const TokenBucket &) = delete;
+
+    /// @brief 尝试获取 n 个令牌，不阻塞
+    /// @return 获取成功返回 true
+    bool try_acquire(uint32_t n = 1) {
+        auto now = clock_->now_ns();
+        auto tat = tat_.load(std::memory_order_relaxed);
+        do {
+            auto next = std::max(tat, now) + n * emission_ns_;
+            if (next - now > tolerance_ns_) {
+                return false;
+            }
+            if (tat_.compare_exchange_weak(tat, next, std::memory_order_relaxed)) {
+                return true;
+            }
+        } while (true);
+    }
+
+    /// @brief 阻塞获取 n 个令牌，等待由 RateLimitWaiter 的共享定时器唤醒
+    /// @return n 超过桶容量时永远无法满足；虚拟时钟只随 advance 推进，共享定时器无法按它唤醒；
+    ///         这两种情况下不等待，获取失败直接返回 false
+    bool acquire(uint32_t n = 1) {
+        if (n * emission_ns_ > tolerance_ns_) {
+            return false;
+        }
+        if (try_acquire(n)) {
+            return true;
+        }
+        if (clock_->is_virtual()) {
+            return false;
+        }
+        RateLimitWaiter::instance().wait(*clock_, [this, n]() { return try_acquire(n); },
+                                         [this, n]() { return wait_time_ns(n); });
+        return true;
+    }
+
+    /// @brief n 个令牌可用还需要等待的时间，单位为ns
+    uint64_t wait_time_ns(uint32_t n = 1) {
+        auto now = clock_->now_ns();
+        auto next = std::max(tat_.load(std::memory_order_relaxed), now) + n * emission_ns_;
+        return next - now > tolerance_ns_ ? next - now - tolerance_ns_ : 0;
+    }
+
+    /// @brief 当前可用的令牌数
+    uint32_t available() {
+        auto now = clock_->now_ns();
+        auto tat = std::max(tat_.load(std::memory_order_relaxed), now);
+        return (tolerance_ns_ - std::min(tolerance_ns_, tat - now)) / emission_ns_;
+    }
+
+   private:
+    const uint64_t emission_ns_;   //< 每个令牌的补充间隔
+    const uint64_t tolerance_ns_;  //< 允许的突发时长
+    ClockSource *clock_;
+    std::atomic<uint64_t> tat_{0};  //< theoretical arrival time
+};
+
+}  // namespace stroll
@@ -11,46 +11,143 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <chrono>
 #include <cinttypes>
 #include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
+#include "utils/clock.hpp"
+#include "utils/futex.hpp"
 #include "utils/logger.hpp"
+#include "utils/mpmc_queue.hpp"
 
 namespace stroll {
 
 using TimerFunc = std::function<void()>;
 
-struct TimerNode {
+/// @brief 自适应定时任务，返回下次执行的延迟，单位为ms，返回 kTimerStop 则停止
+using TimerNextFunc = std::function<int64_t()>;
+
+/// @brief 回调的返回类型，返回 void 的是周期任务，返回延迟的是自适应任务
+template <typename Func>
+using timer_result_t = std::invoke_result_t<std::decay_t<Func> &>;
+
+static const int64_t kTimerStop = -1;
+
+/// @brief 定时器内部告警的限流间隔，同一处告警每秒最多输出一条，其余计入被丢弃次数
+static const uint64_t kWarnIntervalMs = 1000;
+
+struct TimerNode;
+struct TimerLane;
+
+/// @brief 定时器组状态，组内定时器共享一个 epoch
+struct TimerGroupState {
+    std::atomic<uint32_t> epoch{0};                 //< 奇数表示组已停止
+    std::vector<std::weak_ptr<TimerNode>> members;  //< 受 TimerManager 堆锁保护
+
+    bool stopped() const { return epoch.load(std::memory_order_acquire) & 1; }
+};
+
+using TimerGroupHandler = std::shared_ptr<TimerGroupState>;
+
+struct TimerNode : std::enable_shared_from_this<TimerNode> {
     static const uint64_t kMaxTimePoint = 0x7ffffffffffffffful;
 
+    /// @brief 回调执行区间，接管 begin_run 标记的执行，析构时结束
     class RunningGuard {
        public:
-        RunningGuard(std::atomic<bool> &flag) : flag_(flag) { flag_ = true; }
+        RunningGuard(TimerNode &node) : node_(node), prev_(current()) { current() = &node_; }
 
-        ~RunningGuard() { flag_ = false; }
+        ~RunningGuard() {
+            current() = prev_;
+            node_.end_run();
+        }
 
        private:
-        std::atomic<bool> &flag_;
+        TimerNode &node_;
+        TimerNode *prev_;
     };
 
+    /// @brief 当前线程正在执行回调的定时器
+    static TimerNode *&current() {
+        thread_local TimerNode *node = nullptr;
+        return node;
+    }
+
+    /// @brief 标记回调即将执行，需要在持有堆锁时调用，保证 stop 之后能看到
+    void begin_run() {
+        dispatch_seq = arm_seq;
+        run_seq.fetch_add(1);
+    }
+
+    /// @brief 回调结束，run_seq 是唯一的执行标记，变为偶数后才允许再次派发
+    void end_run() {
+        run_seq.fetch_add(1);
+        if (drain_waiters.load() != 0) {
+            futex_wake(run_seq);
+        }
+    }
+
+    /// @brief 等待正在执行的回调结束
+    void wait_idle() {
+        drain_waiters.fetch_add(1);
+        for (auto seq = run_seq.load(); seq & 1; seq = run_seq.load()) {
+            futex_wait(run_seq, seq);
+        }
+        drain_waiters.fetch_sub(1);
+    }
+
     std::string name;
     TimerFunc func;
+    TimerNextFunc next_func;  //< 自适应任务，设置后忽略 func 和 interval_ns
     uint32_t index = 0;
+    uint8_t bucket = 0;  //< RadixHeap 中所在的桶，index 为桶内位置
     uint64_t interval_ns = 0;
     uint64_t delay_ns = 0;
     uint64_t next_tp = kMaxTimePoint;  //< next timepoint
-    std::atomic<bool> running{false};
+    std::atomic<uint32_t> run_seq{0};        //< 奇数表示回调已派发且尚未结束
+    std::atomic<uint32_t> drain_waiters{0};  //< stop_and_wait 等待者数量
+    std::atomic<uint64_t> budget_ns{0};  //< 单次回调允许的最长执行时间，0表示使用看门狗默认值
+    TimerGroupHandler group;   //< 所属定时器组
+    uint32_t group_epoch = 0;  //< 启动时所属组的 epoch
+    bool parked = false;       //< 到期时发现组已停止，等待组恢复时重新启动
+    uint32_t arm_seq = 0;      //< 每次 start/stop/set_interval 递增，受堆锁保护
+    uint32_t dispatch_seq = 0;  //< 派发时的 arm_seq
+    uint64_t pending_tp = kMaxTimePoint;  //< 自适应任务回调返回的下次执行时间
+    TimerNode *pending_next = nullptr;    //< 待重新调度链表
+    TimerLane *lane = nullptr;            //< 所在的周期队列，代理节点指向自己代表的队列
+    TimerNode *lane_prev = nullptr;
+    TimerNode *lane_next = nullptr;
+    uint64_t lane_tp = kMaxTimePoint;  //< 在周期队列中时的下次执行时间，此时堆中为 kMaxTimePoint
+    std::atomic<uint32_t> queue_gen{0};  //< ConcurrentTimerQueue 中的代数，每次 insert/cancel 递增
+    TimerNode *heap_child = nullptr;  //< PairingHeap 中最左的子节点
+    TimerNode *heap_prev = nullptr;   //< PairingHeap 中左兄弟，最左子节点指向父节点
+    TimerNode *heap_next = nullptr;   //< PairingHeap 中右兄弟
+
+    /// @brief 回调已派发且尚未结束
+    bool running() const { return run_seq.load() & 1; }
+
+    /// @brief 所属组是否允许执行，组停止或组 epoch 已变化时不执行
+    bool group_active() const {
+        if (!group) {
+            return true;
+        }
+        auto epoch = group->epoch.load(std::memory_order_acquire);
+        return !(epoch & 1) && epoch == group_epoch;
+    }
 
     bool operator<(const TimerNode &other) { return next_tp < other.next_tp; }
 
@@ -96,7 +193,9 @@ class MinHeap {
         percolate_up(h->index);
     }
 
-    void update_place(const TimerHandler &h, uint64_t tp) {
+    void update_place(const TimerHandler &h, uint64_t tp) { update_place(h.get(), tp); }
+
+    void update_place(TimerNode *h, uint64_t tp) {
         auto old = h->next_tp;
         h->next_tp = tp;
         if (tp > old) {
@@ -184,16 +283,582 @@ class MinHeap {
     std::vector<TimerHandler> buff_;
 };
 
-class TimerManager final {
-    static const unsigned max_thread_num = 4;
+/// @brief 基数堆(单调优先队列)，与 MinHeap 接口相同，可替换使用
+///
+/// 按与 last_ 最高的不同位把节点放入 65 个桶，last_ 只在堆顶到期时推进到堆顶的值，
+/// 此时只需要把最小值所在的桶重新分配到更低的桶，每个节点最多下沉 64 次，
+/// 均摊 O(log C)，几乎不需要比较。定时器新的到期时间总是不早于当前时间，
+/// 而堆顶到期时 last_ 不晚于当前时间，满足单调性要求；早于 last_ 的时间按 last_ 处理，
+/// 此时任务本来就已到期，不影响执行。
+class RadixHeap {
+    static const unsigned kBucketNum = 65;
+
+   public:
+    RadixHeap() = default;
+
+    ~RadixHeap() = default;
+
+    bool empty() const { return size_ == 0; }
+
+    TimerHandler &top() {
+        if (!top_) {
+            find_top();
+        }
+        return buckets_[top_->bucket][top_->index];
+    }
+
+    void update_top(uint64_t tp) {
+        auto &handler = top();
+        auto node = handler.get();
+        //< 推进 last_ 到当前最小值，并重新分配最小值所在的桶
+        if (node->bucket != 0) {
+            last_ = node->next_tp;
+            auto items = std::move(buckets_[node->bucket]);
+            buckets_[node->bucket].clear();
+            for (auto &item : items) {
+                insert(item);
+            }
+        }
+        update_place(node, tp);
+    }
+
+    void push(const TimerHandler &h) {
+        h->next_tp = std::max(h->next_tp, last_);
+        insert(h);
+        ++size_;
+        if (top_ && h->next_tp < top_->next_tp) {
+            top_ = h.get();
+        }
+    }
+
+    void push_and_sort(const TimerHandler &h) { push(h); }
+
+    void update_place(const TimerHandler &h, uint64_t tp) { update_place(h.get(), tp); }
+
+    void update_place(TimerNode *h, uint64_t tp) {
+        tp = std::max(tp, last_);
+        if (tp == h->next_tp) {
+            return;
+        }
+
+        auto handler = remove(h);
+        handler->next_tp = tp;
+        insert(handler);
+        if (top_ == h) {
+            top_ = nullptr;
+        } else if (top_ && tp < top_->next_tp) {
+            top_ = h;
+        }
+    }
+
+    void dump() {
+        for (auto &bucket : buckets_) {
+            for (auto &node : bucket) {
+                node->dump();
+            }
+        }
+        printf("\n");
+    }
+
+   private:
+    unsigned bucket_of(uint64_t tp) const {
+        return tp == last_ ? 0 : 64 - __builtin_clzll(tp ^ last_);
+    }
+
+    void insert(const TimerHandler &h) {
+        auto &bucket = buckets_[bucket_of(h->next_tp)];
+        h->bucket = &bucket - buckets_.data();
+        h->index = bucket.size();
+        bucket.push_back(h);
+    }
+
+    TimerHandler remove(TimerNode *h) {
+        auto &bucket = buckets_[h->bucket];
+        auto handler = std::move(bucket[h->index]);
+        if (h->index + 1 != bucket.size()) {
+            bucket[h->index] = std::move(bucket.back());
+            bucket[h->index]->index = h->index;
+        }
+        bucket.pop_back();
+        return handler;
+    }
+
+    /// @brief 在最低的非空桶中查找最小值，结果缓存到下一次修改
+    void find_top() {
+        for (auto &bucket : buckets_) {
+            if (bucket.empty()) {
+                continue;
+            }
+            top_ = bucket[0].get();
+            for (auto &node : bucket) {
+                if (node->next_tp < top_->next_tp) {
+                    top_ = node.get();
+                }
+            }
+            return;
+        }
+    }
+
+   private:
+    std::array<std::vector<TimerHandler>, kBucketNum> buckets_;
+    uint64_t last_ = 0;
+    size_t size_ = 0;
+    TimerNode *top_ = nullptr;  //< 缓存的堆顶
+};
+
+/// @brief 配对堆，与 MinHeap 接口相同，可替换使用
+///
+/// 节点间的链接直接放在 TimerNode 中，插入和提前到期时间(decrease-key)只需把子树
+/// 剪下再与根合并，O(1)；删除堆顶和推迟到期时间时两趟合并子节点，均摊 O(log n)。
+/// 适合到期时间经常被提前的负载。
+class PairingHeap {
+   public:
+    PairingHeap() { nodes_.reserve(64); }
+
+    ~PairingHeap() = default;
+
+    bool empty() const { return nodes_.empty(); }
+
+    TimerHandler &top() { return nodes_.at(root_->index); }
+
+    void update_top(uint64_t tp) { update_place(root_, tp); }
+
+    void push(const TimerHandler &h) {
+        h->index = nodes_.size();
+        h->heap_child = h->heap_prev = h->heap_next = nullptr;
+        nodes_.push_back(h);
+        root_ = meld(root_, h.get());
+    }
+
+    void push_and_sort(const TimerHandler &h) { push(h); }
+
+    void update_place(const TimerHandler &h, uint64_t tp) { update_place(h.get(), tp); }
+
+    void update_place(TimerNode *h, uint64_t tp) {
+        auto old = h->next_tp;
+        h->next_tp = tp;
+        if (tp < old) {
+            if (h != root_) {
+                cut(h);
+                root_ = meld(root_, h);
+            }
+        } else if (tp > old) {
+            //< 子节点可能比新的到期时间更早，先把它们合并成一棵树，再与自身和其余部分合并
+            auto rest = root_;
+            if (h == root_) {
+                rest = nullptr;
+            } else {
+                cut(h);
+            }
+            auto children = merge_pairs(h->heap_child);
+            h->heap_child = nullptr;
+            root_ = meld(meld(rest, children), h);
+        }
+    }
+
+    void dump() {
+        for (auto &node : nodes_) {
+            node->dump();
+        }
+        printf("\n");
+    }
+
+   private:
+    /// @brief 合并两棵树，到期时间较晚的根成为另一个根的最左子节点
+    static TimerNode *meld(TimerNode *a, TimerNode *b) {
+        if (!a) {
+            return b;
+        }
+        if (!b) {
+            return a;
+        }
+        if (b->next_tp < a->next_tp) {
+            std::swap(a, b);
+        }
+        b->heap_prev = a;
+        b->heap_next = a->heap_child;
+        if (a->heap_child) {
+            a->heap_child->heap_prev = b;
+        }
+        a->heap_child = b;
+        a->heap_prev = a->heap_next = nullptr;
+        return a;
+    }
+
+    /// @brief 把以 h 为根的子树从父节点上剪下
+    static void cut(TimerNode *h) {
+        if (h->heap_prev->heap_child == h) {
+            h->heap_prev->heap_child = h->heap_next;
+        } else {
+            h->heap_prev->heap_next = h->heap_next;
+        }
+        if (h->heap_next) {
+            h->heap_next->heap_prev = h->heap_prev;
+        }
+        h->heap_prev = h->heap_next = nullptr;
+    }
+
+    /// @brief 两趟合并兄弟链表：从左到右两两合并，再从右到左依次合并
+    static TimerNode *merge_pairs(TimerNode *first) {
+        TimerNode *pairs = nullptr;  //< 第一趟的结果，按 heap_next 逆序串起
+        while (first) {
+            auto a = first;
+            auto b = a->heap_next;
+            first = b ? b->heap_next : nullptr;
+            a->heap_prev = a->heap_next = nullptr;
+            if (b) {
+                b->heap_prev = b->heap_next = nullptr;
+            }
+            auto tree = meld(a, b);
+            tree->heap_next = pairs;
+            pairs = tree;
+        }
+
+        TimerNode *root = nullptr;
+        while (pairs) {
+            auto next = pairs->heap_next;
+            pairs->heap_next = nullptr;
+            root = meld(root, pairs);
+            pairs = next;
+        }
+        return root;
+    }
+
+   private:
+    std::vector<TimerHandler> nodes_;  //< 持有所有节点，index 为在其中的位置
+    TimerNode *root_ = nullptr;
+};
+
+/// @brief TimerManager 使用的堆实现，可定义为 MinHeap、RadixHeap 或 PairingHeap
+#ifndef STROLL_TIMER_HEAP
+#define STROLL_TIMER_HEAP MinHeap
+#endif
+
+using TimerHeap = STROLL_TIMER_HEAP;
+
+/// @brief 堆是否允许不加锁并发启动，见 ConcurrentTimerQueue
+template <typename Heap, typename = void>
+struct is_concurrent_heap : std::false_type {};
+
+template <typename Heap>
+struct is_concurrent_heap<Heap, std::void_t<decltype(Heap::kConcurrent)>>
+    : std::bool_constant<Heap::kConcurrent> {};
+
+/// @brief 单线程定时器循环，供 reactor 线程内嵌使用
+///
+/// 定时器只在所属线程上创建、启停和触发，因此不加锁、不使用原子操作，
+/// 由所属事件循环调用 poll(now) 驱动，回调直接在调用 poll 的线程上执行。
+/// next_deadline() 可用于计算 epoll_wait 等调用的超时时间。
+/// 配合 VirtualClock 使用时触发顺序完全确定，可用 run_until 快进仿真。
+class TimerLoop final {
+   public:
+    explicit TimerLoop(ClockSource &clock = SteadyClock::instance()) : clock_(&clock) {}
+
+    ~TimerLoop() = default;
+
+    TimerLoop(const TimerLoop &) = delete;
+    TimerLoop &operator=(const TimerLoop &) = delete;
+
+    /// @brief 添加定时器，添加后处于停止状态，需要调用 start
+    /// @param name 定时器名称
+    /// @param func 定时器任务
+    /// @param interval_ms 周期，为0则只执行一次，单位为ms
+    /// @param delay_ms 第一次延迟执行的时间，单位为ms
+    /// @return
+    TimerHandler add_timer(const char *name, const TimerFunc &func, unsigned interval_ms,
+                           unsigned delay_ms = 0) {
+        auto handler = std::make_shared<TimerNode>();
+        handler->func = func;
+        handler->name = name;
+        handler->interval_ns = 1000ull * 1000 * interval_ms;
+        handler->delay_ns = 1000ull * 1000 * delay_ms;
+        min_heap_.push(handler);
+        return handler;
+    }
+
+    /// @brief 当前时钟源的时间点
+    uint64_t now() { return clock_->now_ns(); }
+
+    int start(const TimerHandler &handler) { return start(handler, now()); }
+
+    /// @brief 以 now 为基准启动定时器
+    int start(const TimerHandler &handler, uint64_t now) {
+        if (!handler) {
+            return 0;
+        }
+        min_heap_.update_place(handler, now + handler->delay_ns);
+        return 0;
+    }
+
+    int stop(const TimerHandler &handler) {
+        if (!handler) {
+            return 0;
+        }
+        min_heap_.update_place(handler, TimerNode::kMaxTimePoint);
+        return 0;
+    }
+
+    int set_interval(const TimerHandler &handler, unsigned ms) {
+        return set_interval(handler, ms, now());
+    }
+
+    /// @brief 设置周期，并以 now 为基准重新计算下次触发时间
+    int set_interval(const TimerHandler &handler, unsigned ms, uint64_t now) {
+        if (!handler) {
+            return 0;
+        }
+        handler->interval_ns = 1000ull * 1000 * ms;
+        min_heap_.update_place(handler, now + handler->interval_ns);
+        return 0;
+    }
+
+    /// @brief 最近一个到期时间点，没有待触发的定时器时返回 kMaxTimePoint
+    uint64_t next_deadline() {
+        return min_heap_.empty() ? TimerNode::kMaxTimePoint : min_heap_.top()->next_tp;
+    }
+
+    unsigned poll() { return poll(now()); }
+
+    /// @brief 执行所有在 now 之前到期的定时器
+    /// @param now 当前时间点，单位为ns
+    /// @return 本次执行的回调个数
+    unsigned poll(uint64_t now) {
+        unsigned count = 0;
+        while (!min_heap_.empty()) {
+            //< 拷贝一份，回调中可能会操作堆
+            auto handler = min_heap_.top();
+            if (handler->next_tp > now) {
+                break;
+            }
+
+            uint64_t next_tp = handler->interval_ns == 0 ? TimerNode::kMaxTimePoint
+                                                         : handler->next_tp + handler->interval_ns;
+            min_heap_.update_top(next_tp);
+            if (handler->func) {
+                handler->func();
+            } else {
+                sl_warn_every_ms(kWarnIntervalMs, "name: %s no callback func\n",
+                                 handler->name.c_str());
+            }
+            ++count;
+        }
+        return count;
+    }
+
+    /// @brief 快进仿真：虚拟时钟逐个跳到下一个到期时间点并执行，最后停在 end_tp
+    /// @param clock 本循环使用的虚拟时钟
+    /// @param end_tp 仿真结束时间点
+    /// @return 执行的回调总数
+    uint64_t run_until(VirtualClock &clock, uint64_t end_tp) {
+        uint64_t count = 0;
+        for (auto deadline = next_deadline(); deadline <= end_tp; deadline = next_deadline()) {
+            clock.advance_to(deadline);
+            count += poll(clock.now_ns());
+        }
+        clock.advance_to(end_tp);
+        return count;
+    }
+
+   private:
+    ClockSource *clock_;
+    MinHeap min_heap_;
+};
+
+/// @brief 相同周期的定时器队列
+///
+/// 同周期的定时器按到期时间先后排成 FIFO，只有队首通过代理节点进入堆，
+/// 队首执行后移到队尾即完成重新调度，O(1)。队列内的到期时间始终落在
+/// [head.lane_tp, head.lane_tp + interval] 内，保证移到队尾后仍然有序。
+struct TimerLane {
+    uint64_t interval_ns = 0;
+    TimerHandler proxy;  //< 堆中代表队首的节点
+    TimerNode *head = nullptr;
+    TimerNode *tail = nullptr;
+};
+
+/// @brief 看门狗发现的超时回调
+struct WatchdogEvent {
+    std::string name;     //< 定时器名称
+    unsigned worker;      //< 执行回调的工作线程编号
+    uint64_t elapsed_ns;  //< 回调已执行的时间
+    uint64_t budget_ns;   //< 回调允许的执行时间
+};
+
+/// @brief 看门狗配置
+struct WatchdogOptions {
+    unsigned period_ms = 100;       //< 检查周期
+    unsigned budget_ms = 0;         //< 默认回调执行时间上限，0表示只检查设置了上限的定时器
+    bool replace_stalled = false;   //< 是否补充新的工作线程替换卡住的线程
+    std::function<void(const WatchdogEvent &)> on_stalled;  //< 为空时打印告警日志
+};
+
+/// @brief 线程池执行器配置，工作线程轮流担任检查线程
+/// @tparam Threads 工作线程数
+template <unsigned Threads>
+struct PoolExecutor {
+    static_assert(Threads >= 1, "at least one worker thread is required");
+    static constexpr unsigned kThreadNum = Threads;
+    static constexpr bool kDispatcher = false;
+};
+
+/// @brief 专用检查线程执行器配置
+///
+/// 一个检查线程只负责找出到期任务，放入无锁运行队列，工作线程从队列取任务执行；
+/// 队列为空时工作线程先自旋 SpinCount 次再休眠，连续到期的任务不需要线程切换。
+/// @tparam Threads 工作线程数，不含检查线程
+/// @tparam SpinCount 休眠前的自旋次数
+template <unsigned Threads, unsigned SpinCount = 1000>
+struct DispatchExecutor {
+    static_assert(Threads >= 1, "at least one worker thread is required");
+    static constexpr unsigned kThreadNum = Threads;
+    static constexpr bool kDispatcher = true;
+    static constexpr unsigned kSpinCount = SpinCount;
+    static constexpr size_t kQueueSize = 1024;  //< 运行队列容量
+};
+
+using DefaultExecutor = PoolExecutor<4>;
 
+/// @brief 自旋锁，堆操作很短时可替代 std::mutex 作为 TimerManager 的堆锁
+class SpinLock {
    public:
-    static TimerManager &instance() {
-        static TimerManager _inst;
+    void lock() {
+        while (flag_.exchange(true, std::memory_order_acquire)) {
+            while (flag_.load(std::memory_order_relaxed)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void unlock() { flag_.store(false, std::memory_order_release); }
+
+   private:
+    std::atomic<bool> flag_{false};
+};
+
+/// @brief 不统计、不打印也不写飞行记录器，所有调用编译后为空
+struct NullStats {
+    void on_fire(const TimerNode &, uint64_t) {}
+    void on_overrun(const TimerNode &) {}
+    void on_no_callback(const TimerNode &) {}
+    void on_retired(unsigned) {}
+    void on_exit(unsigned) {}
+    void dump() {}
+};
+
+/// @brief 触发和跳过写入飞行记录器，异常事件打印告警日志，TimerManager 的默认行为
+struct LogStats : NullStats {
+    void on_fire(const TimerNode &node, uint64_t late_ns) {
+        sl_record("timer %s fired, late %" PRIu64 " ns\n", node.name.c_str(), late_ns);
+    }
+
+    void on_overrun(const TimerNode &node) {
+        sl_record("timer %s overrun\n", node.name.c_str());
+        sl_warn_every_ms(kWarnIntervalMs, "name: %s is running\n", node.name.c_str());
+    }
+
+    void on_retired(unsigned worker) { sl_warn("timer worker %u retired\n", worker); }
+
+    void on_exit(unsigned free_thread_num) {
+        sl_warn("timer thread pool exit, free_thread_num: %u\n", free_thread_num);
+    }
+
+    void on_no_callback(const TimerNode &node) {
+        sl_warn_every_ms(kWarnIntervalMs, "name: %s no callback func\n", node.name.c_str());
+    }
+};
+
+/// @brief 在打印告警之外统计触发次数和触发延迟
+struct CounterStats : LogStats {
+    void on_fire(const TimerNode &node, uint64_t late_ns) {
+        LogStats::on_fire(node, late_ns);
+        fired.fetch_add(1, std::memory_order_relaxed);
+        late_ns_sum.fetch_add(late_ns, std::memory_order_relaxed);
+        auto max = max_late_ns.load(std::memory_order_relaxed);
+        while (late_ns > max && !max_late_ns.compare_exchange_weak(max, late_ns)) {
+        }
+    }
+
+    void on_overrun(const TimerNode &node) {
+        overrun.fetch_add(1, std::memory_order_relaxed);
+        LogStats::on_overrun(node);
+    }
+
+    void dump() {
+        auto count = fired.load();
+        sl_info("fired: %" PRIu64 ", overrun: %" PRIu64 ", late avg: %" PRIu64 " ns, max: %" PRIu64
+                " ns\n",
+                count, overrun.load(), count ? late_ns_sum.load() / count : 0, max_late_ns.load());
+    }
+
+    std::atomic<uint64_t> fired{0};        //< 派发的回调次数
+    std::atomic<uint64_t> overrun{0};      //< 到期时上一次回调仍在执行而跳过的次数
+    std::atomic<uint64_t> late_ns_sum{0};  //< 派发时间晚于到期时间的累计值
+    std::atomic<uint64_t> max_late_ns{0};
+};
+
+/// @brief 默认时钟实例，ClockSource 表示运行时可替换的时钟，默认为 SteadyClock
+template <typename Clock>
+Clock &default_clock() {
+    return Clock::instance();
+}
+
+template <>
+inline ClockSource &default_clock<ClockSource>() {
+    return SteadyClock::instance();
+}
+
+/// @brief 多线程定时器管理器
+///
+/// 各项配置都是编译期参数，关闭的功能不产生运行时开销：
+/// @tparam Heap 堆实现，MinHeap、RadixHeap 或 PairingHeap；
+///         ConcurrentTimerQueue 让启停不经过堆锁，见 concurrent_timer_queue.hpp
+/// @tparam Clock 时钟类型，ClockSource 可在运行时 set_clock 替换；
+///         指定 SteadyClock、CoarseClock 等 final 类时时钟调用可以内联
+/// @tparam Lock 堆锁类型，std::mutex 或 SpinLock
+/// @tparam Executor 线程池配置，见 PoolExecutor
+/// @tparam Stats 事件统计和告警，NullStats、LogStats 或 CounterStats
+template <typename Heap = TimerHeap, typename Clock = ClockSource, typename Lock = std::mutex,
+          typename Executor = DefaultExecutor, typename Stats = LogStats>
+class BasicTimerManager final {
+    static const unsigned max_lane_num = 64;
+    static constexpr bool kConcurrent = is_concurrent_heap<Heap>::value;
+
+    /// @brief 工作线程状态，记录正在执行的回调，供看门狗检查
+    struct WorkerSlot {
+        /// @brief 标记回调的执行区间
+        class Guard {
+           public:
+            Guard(WorkerSlot &slot, TimerNode *node, uint64_t now) : slot_(slot) {
+                slot_.reported = false;
+                slot_.start_ns.store(now, std::memory_order_relaxed);
+                slot_.node.store(node, std::memory_order_release);
+            }
+
+            ~Guard() { slot_.node.store(nullptr, std::memory_order_release); }
+
+           private:
+            WorkerSlot &slot_;
+        };
+
+        explicit WorkerSlot(unsigned worker_id) : id(worker_id) {}
+
+        const unsigned id;
+        std::atomic<TimerNode *> node{nullptr};
+        std::atomic<uint64_t> start_ns{0};
+        std::atomic<bool> reported{false};  //< 本次回调已上报过
+        std::atomic<bool> retired{false};   //< 已被替换，回调结束后退出
+    };
+
+   public:
+    static BasicTimerManager &instance() {
+        static BasicTimerManager _inst;
         return _inst;
     }
 
-    ~TimerManager() { quit_and_wait(); }
+    ~BasicTimerManager() { quit_and_wait(); }
+
+    BasicTimerManager(const BasicTimerManager &) = delete;
+    BasicTimerManager &operator=(const BasicTimerManager &) = delete;
 
     TimerHandler add_timer(const char *name, const TimerFunc &func, unsigned interval_ms,
                            unsigned delay_ms) {
@@ -202,24 +867,51 @@ class TimerManager final {
         handler->name = name;
         handler->interval_ns = 1000ull * 1000 * interval_ms;
         handler->delay_ns = 1000ull * 1000 * delay_ms;
-        mtx_heap_.lock();
-        min_heap_.push(handler);
-        mtx_heap_.unlock();
+        //< 并发队列只保存已启动的定时器
+        if constexpr (!kConcurrent) {
+            mtx_heap_.lock();
+            min_heap_.push(handler);
+            mtx_heap_.unlock();
+        }
         handler->dump();
         return handler;
     }
 
-    int start(TimerHandler &handler) {
+    /// @brief 添加自适应定时器，回调的返回值决定下次执行的延迟
+    TimerHandler add_timer(const char *name, const TimerNextFunc &func, unsigned delay_ms) {
+        auto handler = add_timer(name, TimerFunc(), 0, delay_ms);
+        handler->next_func = func;
+        return handler;
+    }
+
+    int start(TimerHandler &handler) { return handler ? start_after(handler, handler->delay_ns) : 0; }
+
+    /// @brief 以指定的延迟启动定时器，不改变构造时设置的首次延迟
+    int start_after(TimerHandler &handler, uint64_t delay_ns) {
         if (!handler) {
             return 0;
         }
-
-        {
-            std::lock_guard guard(mtx_heap_);
-            auto next_tp = get_system_ns() + handler->delay_ns;
-            min_heap_.update_place(handler, next_tp);
+        if constexpr (kConcurrent) {
+            auto next_tp = get_system_ns() + delay_ns;
+            min_heap_.insert(handler, next_tp);
+            wakeup_if_earlier(next_tp);
+        } else {
+            bool wakeup;
+            {
+                std::lock_guard guard(mtx_heap_);
+                auto next_tp = get_system_ns() + delay_ns;
+                if (handler->group) {
+                    handler->group_epoch = handler->group->epoch.load(std::memory_order_acquire);
+                }
+                handler->parked = false;
+                ++handler->arm_seq;
+                schedule(handler.get(), next_tp);
+                wakeup = need_wakeup(next_tp);
+            }
+            if (wakeup) {
+                set_heap_update_flag();
+            }
         }
-        set_heap_update_flag();
         return 0;
     }
 
@@ -227,13 +919,41 @@ class TimerManager final {
         if (!handler) {
             return 0;
         }
+        if constexpr (kConcurrent) {
+            //< 失效的条目到达队首时丢弃，不需要唤醒检查线程
+            min_heap_.cancel(handler);
+        } else {
+            {
+                std::lock_guard guard(mtx_heap_);
+                auto next_tp = TimerNode::kMaxTimePoint;
+                handler->parked = false;
+                ++handler->arm_seq;
+                schedule(handler.get(), next_tp);
+            }
+            set_heap_update_flag();
+        }
+        return 0;
+    }
+
+    /// @brief 停止定时器并等待正在执行的回调结束，返回后回调不会再执行
+    ///
+    /// 回调在持有堆锁时被标记为已派发，stop 拿到堆锁后要么能看到标记，
+    /// 要么该回调不会再被派发，因此只需等待节点自身的执行序号变为偶数。
+    /// @return 在回调内部停止自身时无法等待，只停止并返回 -1
+    int stop_and_wait(TimerHandler &handler) {
+        if (!handler) {
+            return 0;
+        }
 
-        {
+        stop(handler);
+        if constexpr (kConcurrent) {
+            //< 检查线程在堆锁内完成代数检查和派发标记，拿到堆锁后两者都已可见
             std::lock_guard guard(mtx_heap_);
-            auto next_tp = TimerNode::kMaxTimePoint;
-            min_heap_.update_place(handler, next_tp);
         }
-        set_heap_update_flag();
+        if (TimerNode::current() == handler.get()) {
+            return -1;
+        }
+        handler->wait_idle();
         return 0;
     }
 
@@ -241,29 +961,173 @@ class TimerManager final {
         if (!handler) {
             return 0;
         }
+        if constexpr (kConcurrent) {
+            {
+                //< 检查线程在堆锁内读取 interval_ns 重新启动周期任务
+                std::lock_guard guard(mtx_heap_);
+                handler->interval_ns = 1000ull * 1000 * ms;
+            }
+            start_after(handler, 1000ull * 1000 * ms);
+        } else {
+            bool wakeup;
+            {
+                std::lock_guard guard(mtx_heap_);
+                handler->interval_ns = 1000ull * 1000 * ms;
+                auto next_tp = get_system_ns() + handler->interval_ns;
+                ++handler->arm_seq;
+                schedule(handler.get(), next_tp);
+                wakeup = need_wakeup(next_tp);
+            }
+            if (wakeup) {
+                set_heap_update_flag();
+            }
+        }
+        return 0;
+    }
+
+    /// @brief 设置时钟源，需要在启动任何定时器之前调用
+    /// @param clock 时钟源，生命周期需要长于 TimerManager
+    void set_clock(Clock &clock) {
+        clock_ = &clock;
+        if constexpr (std::is_base_of_v<Clock, VirtualClock>) {
+            if (clock.is_virtual()) {
+                //< 虚拟时钟推进后唤醒检查线程，重新判断到期任务
+                static_cast<VirtualClock &>(clock).set_wakeup([this]() { set_heap_update_flag(); });
+            }
+        }
+        set_heap_update_flag();
+    }
+
+    /// @brief 将定时器加入组，一个定时器只能属于一个组
+    int join_group(TimerHandler &handler, const TimerGroupHandler &group) {
+        static_assert(!kConcurrent, "ConcurrentTimerQueue does not support timer groups");
+        if (!handler || !group) {
+            return 0;
+        }
+
+        std::lock_guard guard(mtx_heap_);
+        if (handler->group == group) {
+            return 0;
+        }
+        if (handler->group) {
+            prune_members(*handler->group, handler.get());
+        }
+        handler->group = group;
+        handler->group_epoch = group->epoch.load(std::memory_order_acquire);
+        prune_members(*group);
+        group->members.push_back(handler);
+        return 0;
+    }
+
+    /// @brief 将定时器移出所属的组，定时器对象销毁时调用
+    int leave_group(TimerHandler &handler) {
+        if (!handler) {
+            return 0;
+        }
+
+        std::lock_guard guard(mtx_heap_);
+        if (handler->group) {
+            prune_members(*handler->group, handler.get());
+            handler->group.reset();
+        }
+        return 0;
+    }
+
+    /// @brief 停止整个组，只翻转组 epoch，O(1)，不操作堆也不唤醒检查线程
+    ///
+    /// 组内定时器到期时由检查线程发现 epoch 变化，挂起而不执行
+    int stop_group(const TimerGroupHandler &group) {
+        if (!group) {
+            return 0;
+        }
+
+        auto epoch = group->epoch.load(std::memory_order_acquire);
+        while (!(epoch & 1) && !group->epoch.compare_exchange_weak(epoch, epoch + 1)) {
+        }
+        return 0;
+    }
+
+    /// @brief 恢复整个组，在一次加锁内批量重新启动组内未被单独停止的定时器
+    int start_group(const TimerGroupHandler &group) {
+        if (!group) {
+            return 0;
+        }
 
         {
             std::lock_guard guard(mtx_heap_);
-            handler->interval_ns = 1000ull * 1000 * ms;
-            auto next_tp = get_system_ns() + handler->interval_ns;
-            min_heap_.update_place(handler, next_tp);
+            auto epoch = group->epoch.load(std::memory_order_acquire);
+            //< 组没有停止过，成员仍按原计划运行，不能重新计时
+            if (!(epoch & 1)) {
+                return 0;
+            }
+            ++epoch;
+            group->epoch.store(epoch, std::memory_order_release);
+
+            prune_members(*group);
+            auto now = get_system_ns();
+            for (auto &member : group->members) {
+                auto handler = member.lock();
+                if (!handler || (!handler->parked && !armed(handler.get()))) {
+                    continue;
+                }
+                handler->parked = false;
+                handler->group_epoch = epoch;
+                ++handler->arm_seq;
+                schedule(handler.get(), now + handler->delay_ns);
+            }
         }
         set_heap_update_flag();
         return 0;
     }
 
+    /// @brief 开启看门狗，检查执行时间超过上限的回调
+    ///
+    /// 超时的回调只上报一次；开启替换后会补充一个新的工作线程，
+    /// 卡住的线程在回调返回后退出，线程池的处理能力不受影响。
+    /// @param options 看门狗配置，重复调用会更新配置
+    void enable_watchdog(const WatchdogOptions &options) {
+        std::lock_guard guard(mtx_tp_);
+        watchdog_ = options;
+        if (!watchdog_thread_.joinable() && !exit_flag_) {
+            watchdog_thread_ = std::thread(&BasicTimerManager::on_watchdog, this);
+        }
+        watchdog_cond_.notify_all();
+    }
+
+    /// @brief 设置调度粒度，检查线程只在 tick 边界醒来，每个 tick 最多唤醒一次
+    ///
+    /// 到期时间对齐到 tick 边界后再等待，同一 tick 内到期的任务合并为一次唤醒；
+    /// 启动晚于当前计划唤醒时间的任务也不再唤醒检查线程。
+    /// 低精度定时器可以配合 CoarseClock 使用，读时钟和唤醒都只付出粗粒度的代价。
+    /// @param ms 调度粒度，为0时恢复精确调度，单位为ms
+    void set_tick(unsigned ms) {
+        {
+            std::lock_guard guard(mtx_heap_);
+            tick_ns_ = 1000ull * 1000 * ms;
+        }
+        set_heap_update_flag();
+    }
+
+    /// @brief 事件统计，类型由 Stats 参数决定
+    Stats &stats() { return stats_; }
+
     void dump() {
         sl_info("free thread number:%d \n", free_thread_num_);
         min_heap_.dump();
+        stats_.dump();
     }
 
    private:
-    TimerManager() {
-        for (auto i = 0u; i < max_thread_num; ++i) {
-            thread_pool_[i] = std::thread(&TimerManager::on_work, this);
+    BasicTimerManager() {
+        std::unique_lock lock(mtx_tp_);
+        for (auto i = 0u; i < Executor::kThreadNum; ++i) {
+            spawn_worker();
+        }
+        if constexpr (Executor::kDispatcher) {
+            dispatcher_thread_ = std::thread(&BasicTimerManager::on_dispatch, this);
+            return;
         }
 
-        std::unique_lock lock(mtx_tp_);
         wakeup_flag_ = true;
         if (!exit_flag_) {
             cond_.notify_one();
@@ -272,7 +1136,17 @@ class TimerManager final {
         }
     }
 
-    void on_work() {
+    /// @brief 创建一个工作线程，需要持有 mtx_tp_
+    void spawn_worker() {
+        auto &slot = worker_slots_.emplace_back(worker_slots_.size());
+        if constexpr (Executor::kDispatcher) {
+            thread_pool_.emplace_back(&BasicTimerManager::on_run, this, &slot);
+        } else {
+            thread_pool_.emplace_back(&BasicTimerManager::on_work, this, &slot);
+        }
+    }
+
+    void on_work(WorkerSlot *slot) {
         while (!exit_flag_) {
             //< 线程先统一阻塞，等待唤醒一个线程做为检测线程
             {
@@ -288,12 +1162,23 @@ class TimerManager final {
             }
 
             //< 检查定时任务
-            check_and_dispatch();
+            check_and_dispatch(*slot);
+
+            //< 已被看门狗替换，卡住的回调结束后直接退出
+            if (slot->retired) {
+                stats_.on_retired(slot->id);
+                return;
+            }
         }
-        sl_warn("timer thread pool exit, free_thread_num: %u\n", free_thread_num_);
+        unsigned free_thread_num;
+        {
+            std::lock_guard lock(mtx_tp_);
+            free_thread_num = free_thread_num_;
+        }
+        stats_.on_exit(free_thread_num);
     }
 
-    void check_and_dispatch() {
+    void check_and_dispatch(WorkerSlot &slot) {
         auto handler = check_task();
         if (!handler) {
             return;
@@ -306,18 +1191,143 @@ class TimerManager final {
             cond_.notify_one();
         }
 
-        TimerNode::RunningGuard running_guard(handler->running);
-        if (handler->func) {
-            handler->func();
+        execute(slot, *handler);
+    }
+
+    /// @brief 执行已由 check_task 标记派发的回调
+    void execute(WorkerSlot &slot, TimerNode &node) {
+        TimerNode::RunningGuard running_guard(node);
+        typename WorkerSlot::Guard slot_guard(slot, &node, get_system_ns());
+        if (node.next_func) {
+            post_reschedule(node, node.next_func());
+        } else if (node.func) {
+            node.func();
         } else {
-            sl_warn("name: %s no callback func\n", handler->name.c_str());
+            stats_.on_no_callback(node);
+        }
+    }
+
+    /// @brief 专用检查线程，把到期任务放入运行队列
+    void on_dispatch() {
+        while (!exit_flag_) {
+            auto handler = check_task();
+            if (!handler) {
+                continue;
+            }
+
+            //< 队列满说明工作线程都在忙，等它们取走任务
+            while (!run_queue_.push(handler.get())) {
+                if (exit_flag_) {
+                    handler->end_run();
+                    return;
+                }
+                std::this_thread::yield();
+            }
+            ready_seq_.fetch_add(1);
+            if (idle_workers_.load() != 0) {
+                futex_wake(ready_seq_, 1);
+            }
+        }
+    }
+
+    /// @brief 专用检查线程模式下的工作线程，从运行队列取任务执行
+    void on_run(WorkerSlot *slot) {
+        while (auto node = pop_ready()) {
+            execute(*slot, *node);
+            if (slot->retired) {
+                stats_.on_retired(slot->id);
+                return;
+            }
+        }
+    }
+
+    /// @brief 从运行队列取任务，先自旋再休眠，退出时返回空
+    TimerNode *pop_ready() {
+        TimerNode *node = nullptr;
+        for (auto i = 0u; i < spin_count(); ++i) {
+            if (run_queue_.pop(node)) {
+                return node;
+            }
+            cpu_relax();
+        }
+
+        while (!exit_flag_) {
+            //< 先读序号再检查队列，检查线程放入任务后递增序号，futex_wait 不会错过
+            auto seq = ready_seq_.load();
+            if (run_queue_.pop(node)) {
+                return node;
+            }
+            idle_workers_.fetch_add(1);
+            futex_wait(ready_seq_, seq);
+            idle_workers_.fetch_sub(1);
+        }
+        return nullptr;
+    }
+
+    static constexpr unsigned spin_count() {
+        if constexpr (Executor::kDispatcher) {
+            return Executor::kSpinCount;
+        } else {
+            return 0;
+        }
+    }
+
+    static constexpr size_t queue_size() {
+        if constexpr (Executor::kDispatcher) {
+            return Executor::kQueueSize;
+        } else {
+            return 2;
+        }
+    }
+
+    /// @brief 自适应任务执行完毕，把下次执行时间交给检查线程
+    ///
+    /// 节点压入无锁链表，由检查线程在下一次持有堆锁时统一调整位置，
+    /// 工作线程不需要再拿堆锁，只有新时间早于检查线程计划醒来的时间才唤醒它。
+    void post_reschedule(TimerNode &node, int64_t delay_ms) {
+        if (delay_ms < 0) {
+            //< 派发时已经停在 kMaxTimePoint
+            return;
+        }
+
+        auto tp = get_system_ns() + 1000ull * 1000 * delay_ms;
+        node.pending_tp = tp;
+        node.pending_next = pending_head_.load(std::memory_order_relaxed);
+        while (!pending_head_.compare_exchange_weak(node.pending_next, &node)) {
+        }
+        wakeup_if_earlier(tp);
+    }
+
+    /// @brief 应用自适应任务返回的下次执行时间，需要持有 mtx_heap_
+    ///
+    /// 回调执行期间被 start/stop/set_interval 过的节点以最新的操作为准
+    void apply_pending() {
+        auto node = pending_head_.exchange(nullptr);
+        while (node) {
+            auto next = node->pending_next;
+            if constexpr (kConcurrent) {
+                min_heap_.insert_if(node->shared_from_this(), node->pending_tp, node->dispatch_seq);
+            } else if (node->arm_seq == node->dispatch_seq) {
+                schedule(node, node->pending_tp);
+            }
+            node = next;
         }
     }
 
     TimerHandler check_task() {
+        if constexpr (kConcurrent) {
+            return check_queue();
+        } else {
+            return check_heap();
+        }
+    }
+
+    TimerHandler check_heap() {
         while (!exit_flag_) {
             std::unique_lock lock(mtx_heap_);
+            apply_pending();
             if (min_heap_.empty()) {
+                planned_wakeup_ = TimerNode::kMaxTimePoint;
                 lock.unlock();
                 //< 等待定时任务加入
                 sleep_checker_for(TimerNode::kMaxTimePoint);
@@ -325,31 +1335,106 @@ class TimerManager final {
             }
 
             auto handler = min_heap_.top();
-            if (get_system_ns() >= handler->next_tp) {
-                uint64_t next_tp = handler->interval_ns == 0
-                                       ? TimerNode::kMaxTimePoint
-                                       : handler->next_tp + handler->interval_ns;
-                min_heap_.update_top(next_tp);
+            auto now = get_system_ns();
+            if (now >= handler->next_tp) {
+                planned_wakeup_ = 0;
+                auto late_ns = now - handler->next_tp;
+                //< 堆顶是周期队列的代理节点，实际到期的是队首
+                auto lane = lane_of_proxy(handler.get());
+                if (lane) {
+                    handler = lane->head->shared_from_this();
+                }
+
+                //< 所属组已停止，挂起等待组恢复
+                if (!handler->group_active()) {
+                    handler->parked = true;
+                    if (lane) {
+                        lane_remove(handler.get());
+                    } else {
+                        min_heap_.update_top(TimerNode::kMaxTimePoint);
+                    }
+                    continue;
+                }
+
+                reschedule_expired(handler.get(), lane);
                 //< 正在运行的任务，推迟到下一个周期，防止耗时任务把线程池全部阻塞
-                if (handler->running) {
-                    sl_warn("name: %s is running\n", handler->name.c_str());
+                if (handler->running()) {
+                    stats_.on_overrun(*handler);
                     continue;
                 }
+                handler->begin_run();
+                stats_.on_fire(*handler, late_ns);
                 return handler;
             }
+            auto wakeup_tp = align_to_tick(handler->next_tp);
+            planned_wakeup_ = wakeup_tp;
+            //< 与 post_reschedule 配合：先公布计划醒来时间再检查链表，不会漏掉
+            if (pending_head_.load()) {
+                continue;
+            }
             lock.unlock();
 
             //< 等待定时任务到期
-            sleep_checker_for(handler->next_tp);
+            sleep_checker_for(wakeup_tp);
         }
         return nullptr;
     }
 
+    /// @brief ConcurrentTimerQueue 的检查流程，堆锁只保证同一时刻只有一个检查线程
+    ///
+    /// 周期任务取出后只在代数不变时重新插入，期间被 start/stop 过的以最新的操作为准；
+    /// 自适应任务记下派发时的代数，apply_pending 用它做同样的判断。
+    TimerHandler check_queue() {
+        while (!exit_flag_) {
+            std::unique_lock lock(mtx_heap_);
+            apply_pending();
+            auto now = get_system_ns();
+            uint64_t tp = 0;
+            uint32_t gen = 0;
+            auto handler = min_heap_.delete_min(now, tp, gen);
+            if (handler) {
+                planned_wakeup_ = 0;
+                auto late_ns = now - tp;
+                if (handler->interval_ns != 0 && !handler->next_func) {
+                    min_heap_.insert_if(handler, tp + handler->interval_ns, gen);
+                }
+                if (handler->running()) {
+                    stats_.on_overrun(*handler);
+                    continue;
+                }
+                handler->begin_run();
+                handler->dispatch_seq = gen;
+                stats_.on_fire(*handler, late_ns);
+                return handler;
+            }
+
+            auto next_tp = min_heap_.next_deadline();
+            auto wakeup_tp = align_to_tick(next_tp);
+            planned_wakeup_ = wakeup_tp;
+            //< 先公布计划醒来时间再检查队首，与 wakeup_if_earlier 配合不会漏掉更早的任务
+            if (min_heap_.next_deadline() < next_tp || pending_head_.load()) {
+                continue;
+            }
+            lock.unlock();
+            sleep_checker_for(wakeup_tp);
+        }
+        return nullptr;
+    }
+
+    /// @brief 不持有堆锁启动的任务早于检查线程计划醒来的时间时唤醒它
+    void wakeup_if_earlier(uint64_t tp) {
+        auto planned = planned_wakeup_.load();
+        if (planned != 0 && tp < planned) {
+            set_heap_update_flag();
+        }
+    }
+
     void sleep_checker_for(uint64_t next_tp) {
         auto func = [this]() -> bool { return exit_flag_ || heap_update_flag_; };
 
         std::unique_lock checker_lock(checker_mtx_);
-        if (next_tp != TimerNode::kMaxTimePoint) {
+        //< 虚拟时钟与真实时间无关，只能等待时钟推进的通知
+        if (next_tp != TimerNode::kMaxTimePoint && !clock_.load()->is_virtual()) {
             auto tp = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(next_tp));
             checker_cond_.wait_until(checker_lock, tp, func);
         } else {
@@ -358,37 +1443,245 @@ class TimerManager final {
         heap_update_flag_ = false;
     }
 
-    uint64_t get_system_ns() {
-        return std::chrono::steady_clock::now().time_since_epoch().count();
+    /// @brief 从组中移除 node 和已经释放的定时器，需要持有 mtx_heap_
+    static void prune_members(TimerGroupState &group, const TimerNode *node = nullptr) {
+        auto &members = group.members;
+        members.erase(std::remove_if(members.begin(), members.end(),
+                                     [node](const std::weak_ptr<TimerNode> &member) {
+                                         auto locked = member.lock();
+                                         return !locked || locked.get() == node;
+                                     }),
+                      members.end());
+    }
+
+    /// @brief 定时器是否处于启动状态，需要持有 mtx_heap_
+    static bool armed(const TimerNode *node) {
+        return node->lane || node->next_tp != TimerNode::kMaxTimePoint;
+    }
+
+    static TimerLane *lane_of_proxy(TimerNode *node) {
+        return node->lane && node->lane->proxy.get() == node ? node->lane : nullptr;
+    }
+
+    /// @brief 把节点调度到 tp，需要持有 mtx_heap_
+    ///
+    /// 周期任务能放入同周期队列时只挂到队尾，堆中节点停在 kMaxTimePoint
+    void schedule(TimerNode *node, uint64_t tp) {
+        lane_remove(node);
+        if (tp != TimerNode::kMaxTimePoint && lane_append(node, tp)) {
+            min_heap_.update_place(node, TimerNode::kMaxTimePoint);
+        } else {
+            min_heap_.update_place(node, tp);
+        }
+    }
+
+    /// @brief 到期任务计算下一次执行时间，需要持有 mtx_heap_，node 为堆顶或 lane 的队首
+    void reschedule_expired(TimerNode *node, TimerLane *lane) {
+        if (lane) {
+            //< 队首移到队尾，O(1)，代理节点随新的队首调整
+            node->lane_tp += lane->interval_ns;
+            if (lane->head != lane->tail) {
+                lane->head = node->lane_next;
+                lane->head->lane_prev = nullptr;
+                node->lane_prev = lane->tail;
+                node->lane_next = nullptr;
+                lane->tail->lane_next = node;
+                lane->tail = node;
+            }
+            min_heap_.update_top(lane->head->lane_tp);
+            return;
+        }
+
+        //< 自适应任务执行期间停在 kMaxTimePoint，执行完由 apply_pending 重新调度
+        uint64_t next_tp = node->interval_ns == 0 || node->next_func
+                               ? TimerNode::kMaxTimePoint
+                               : node->next_tp + node->interval_ns;
+        //< 周期任务执行一次后就能按顺序并入同周期队列
+        if (next_tp != TimerNode::kMaxTimePoint && lane_append(node, next_tp)) {
+            next_tp = TimerNode::kMaxTimePoint;
+        }
+        min_heap_.update_top(next_tp);
+    }
+
+    /// @brief 尝试把周期任务挂到同周期队列队尾，需要持有 mtx_heap_
+    /// @return 不满足队列顺序要求或队列数已满时返回 false
+    bool lane_append(TimerNode *node, uint64_t tp) {
+        if (node->interval_ns == 0 || node->next_func) {
+            return false;
+        }
+
+        auto &lane = lanes_[node->interval_ns];
+        if (!lane) {
+            if (lanes_.size() > max_lane_num) {
+                lanes_.erase(node->interval_ns);
+                return false;
+            }
+            lane = std::make_unique<TimerLane>();
+            lane->interval_ns = node->interval_ns;
+            lane->proxy = std::make_shared<TimerNode>();
+            lane->proxy->name = "lane";
+            lane->proxy->lane = lane.get();
+            min_heap_.push(lane->proxy);
+        }
+
+        if (lane->head &&
+            (tp < lane->tail->lane_tp || tp > lane->head->lane_tp + lane->interval_ns)) {
+            return false;
+        }
+
+        node->lane = lane.get();
+        node->lane_tp = tp;
+        node->lane_prev = lane->tail;
+        node->lane_next = nullptr;
+        if (lane->tail) {
+            lane->tail->lane_next = node;
+        } else {
+            lane->head = node;
+            min_heap_.update_place(lane->proxy, tp);
+        }
+        lane->tail = node;
+        return true;
     }
 
+    /// @brief 从所在的周期队列中摘除，需要持有 mtx_heap_
+    void lane_remove(TimerNode *node) {
+        auto lane = node->lane;
+        if (!lane) {
+            return;
+        }
+
+        auto was_head = lane->head == node;
+        (node->lane_prev ? node->lane_prev->lane_next : lane->head) = node->lane_next;
+        (node->lane_next ? node->lane_next->lane_prev : lane->tail) = node->lane_prev;
+        node->lane = nullptr;
+        node->lane_prev = node->lane_next = nullptr;
+        node->lane_tp = TimerNode::kMaxTimePoint;
+        if (was_head) {
+            min_heap_.update_place(lane->proxy,
+                                   lane->head ? lane->head->lane_tp : TimerNode::kMaxTimePoint);
+        }
+    }
+
+    /// @brief 对齐到 tick 边界，需要持有 mtx_heap_
+    ///
+    /// 额外加上时钟精度，保证粗粒度时钟在唤醒时已经越过到期时间，不会空转
+    uint64_t align_to_tick(uint64_t tp) {
+        if (tick_ns_ == 0 || tp == TimerNode::kMaxTimePoint) {
+            return tp;
+        }
+        tp += clock_.load(std::memory_order_acquire)->resolution_ns();
+        return (tp + tick_ns_ - 1) / tick_ns_ * tick_ns_;
+    }
+
+    /// @brief 新的到期时间是否需要唤醒检查线程，需要持有 mtx_heap_
+    bool need_wakeup(uint64_t tp) { return tick_ns_ == 0 || align_to_tick(tp) < planned_wakeup_; }
+
+    uint64_t get_system_ns() { return clock_.load(std::memory_order_acquire)->now_ns(); }
+
     void set_heap_update_flag() {
         std::unique_lock lock(checker_mtx_);
         heap_update_flag_ = true;
         checker_cond_.notify_one();
     }
 
+    void on_watchdog() {
+        std::unique_lock lock(mtx_tp_);
+        while (!exit_flag_) {
+            watchdog_cond_.wait_for(lock, std::chrono::milliseconds(watchdog_.period_ms));
+            if (exit_flag_) {
+                break;
+            }
+
+            auto now = get_system_ns();
+            auto default_budget = 1000ull * 1000 * watchdog_.budget_ms;
+            std::vector<WatchdogEvent> events;
+            //< 替换线程会追加新的槽位，只检查已有的槽位
+            for (auto i = 0u, size = (unsigned)worker_slots_.size(); i < size; ++i) {
+                auto &slot = worker_slots_[i];
+                auto node = slot.node.load(std::memory_order_acquire);
+                if (!node || slot.reported || slot.retired) {
+                    continue;
+                }
+
+                auto budget = node->budget_ns.load(std::memory_order_relaxed);
+                budget = budget ? budget : default_budget;
+                auto start = slot.start_ns.load(std::memory_order_relaxed);
+                if (budget == 0 || now < start || now - start <= budget) {
+                    continue;
+                }
+
+                slot.reported = true;
+                events.push_back({node->name, slot.id, now - start, budget});
+                if (watchdog_.replace_stalled) {
+                    slot.retired = true;
+                    spawn_worker();
+                }
+            }
+
+            //< 上报时不持有线程池锁
+            auto on_stalled = watchdog_.on_stalled;
+            lock.unlock();
+            for (auto &event : events) {
+                if (on_stalled) {
+                    on_stalled(event);
+                } else {
+                    sl_warn_every_ms(kWarnIntervalMs,
+                                     "name: %s stalled on worker %u, elapsed %" PRIu64
+                                     " ms, budget %" PRIu64 " ms\n",
+                                     event.name.c_str(), event.worker, event.elapsed_ns / 1000 / 1000,
+                                     event.budget_ns / 1000 / 1000);
+                }
+            }
+            lock.lock();
+        }
+    }
+
     void quit_and_wait() {
         mtx_tp_.lock();
         exit_flag_ = true;
         cond_.notify_all();
+        watchdog_cond_.notify_all();
         mtx_tp_.unlock();
 
         //< 唤醒等待的检查器，准备退出
         set_heap_update_flag();
+        if constexpr (Executor::kDispatcher) {
+            if (dispatcher_thread_.joinable()) {
+                dispatcher_thread_.join();
+            }
+            ready_seq_.fetch_add(1);
+            futex_wake(ready_seq_);
+        }
+
+        //< 先停止看门狗，之后线程池不会再增加线程
+        if (watchdog_thread_.joinable()) {
+            watchdog_thread_.join();
+        }
 
         //< 等待所有线程退出
-        for (auto i = 0u; i < max_thread_num; ++i) {
-            auto &thr = thread_pool_[i];
+        for (auto &thr : thread_pool_) {
             if (thr.joinable()) {
                 thr.join();
             }
         }
+
+        //< 已派发但没有执行的任务结束执行标记，之后的 stop_and_wait 不会一直等待
+        if constexpr (Executor::kDispatcher) {
+            TimerNode *node = nullptr;
+            while (run_queue_.pop(node)) {
+                node->end_run();
+            }
+        }
     }
 
    private:
-    std::mutex mtx_heap_;
-    MinHeap min_heap_;
+    std::atomic<Clock *> clock_{&default_clock<Clock>()};
+    Lock mtx_heap_;
+    Heap min_heap_;
+    uint64_t tick_ns_ = 0;
+    std::atomic<uint64_t> planned_wakeup_{0};  //< 检查线程计划醒来的时间点，0表示检查线程未睡眠
+    std::atomic<TimerNode *> pending_head_{nullptr};  //< 待重新调度的自适应任务
+    std::unordered_map<uint64_t, std::unique_ptr<TimerLane>> lanes_;  //< 按周期划分的队列
 
     std::condition_variable checker_cond_;
     std::mutex checker_mtx_;
@@ -396,49 +1689,131 @@ class TimerManager final {
     //< 线程池
     std::condition_variable cond_;
     std::mutex mtx_tp_;
-    std::array<std::thread, max_thread_num> thread_pool_;
+    std::vector<std::thread> thread_pool_;
+    std::deque<WorkerSlot> worker_slots_;
     bool wakeup_flag_{false};
     uint8_t free_thread_num_ = 0;
+    //< 专用检查线程模式
+    std::thread dispatcher_thread_;
+    MpmcQueue<TimerNode *> run_queue_{queue_size()};
+    std::atomic<uint32_t> ready_seq_{0};     //< 每放入一个任务递增，工作线程在此休眠
+    std::atomic<uint32_t> idle_workers_{0};  //< 休眠中的工作线程数
+    //< 看门狗
+    std::thread watchdog_thread_;
+    std::condition_variable watchdog_cond_;
+    WatchdogOptions watchdog_;
     //< 系统退出
-    bool exit_flag_{false};
+    std::atomic<bool> exit_flag_{false};
+    Stats stats_;
 };
 
-/// @brief 定时器对外类
-class Timer {
+/// @brief 默认配置的定时器管理器
+using TimerManager = BasicTimerManager<>;
+
+template <typename Manager>
+class BasicTimerGroup;
+
+/// @brief 定时器对外类，Manager 为所使用的 BasicTimerManager
+template <typename Manager>
+class BasicTimer {
    public:
     /// @brief 构造一个定时器对象
     /// @param name 定时器名称
     /// @param func 定时器定期执行的任务
     /// @param interval_ms 定时器定期执行任务的周期,如果为0，则只执行一次， 单位为ms
     /// @param delay_ms 第一次延迟执行的时间，stop后重新start的话也会生效
-    Timer(const char *name, const TimerFunc &func, unsigned interval_ms, unsigned delay_ms = 0) {
-        handler_ = TimerManager::instance().add_timer(name, func, interval_ms, delay_ms);
+    template <typename Func, std::enable_if_t<std::is_void_v<timer_result_t<Func>>, int> = 0>
+    BasicTimer(const char *name, Func &&func, unsigned interval_ms, unsigned delay_ms = 0) {
+        handler_ = Manager::instance().add_timer(name, TimerFunc(std::forward<Func>(func)),
+                                                 interval_ms, delay_ms);
+    }
+
+    /// @brief 构造一个自适应定时器，每次执行后由回调返回下次执行的延迟
+    ///
+    /// 回调有返回值时只匹配这个构造函数，首次延迟必须写成 std::chrono::milliseconds，
+    /// 误传周期参数会编译失败，而不是被当成周期任务。
+    /// @param name 定时器名称
+    /// @param func 定时器任务，返回下次执行的延迟(ms)，返回 kTimerStop 则停止
+    /// @param delay 第一次延迟执行的时间
+    template <typename Func,
+              std::enable_if_t<std::is_convertible_v<timer_result_t<Func>, int64_t>, int> = 0>
+    BasicTimer(const char *name, Func &&func,
+               std::chrono::milliseconds delay = std::chrono::milliseconds(0)) {
+        handler_ = Manager::instance().add_timer(name, TimerNextFunc(std::forward<Func>(func)),
+                                                 delay.count());
     }
 
     /// @brief 销毁定时器对象
-    ~Timer() { TimerManager::instance().stop(handler_); }
+    ~BasicTimer() {
+        Manager::instance().leave_group(handler_);
+        Manager::instance().stop(handler_);
+    }
 
     /// @brief 开始定时器, 对于只执行一次的任务，start后会重新执行
     /// @return
-    int start() { return TimerManager::instance().start(handler_); }
+    int start() { return Manager::instance().start(handler_); }
+
+    /// @brief 以指定的延迟开始定时器，只影响这一次启动，已启动时重新计时
+    int start(std::chrono::milliseconds delay) {
+        return Manager::instance().start_after(handler_, 1000ull * 1000 * delay.count());
+    }
 
     /// @brief 停止定时器
     /// @return
-    int stop() { return TimerManager::instance().stop(handler_); }
+    int stop() { return Manager::instance().stop(handler_); }
+
+    /// @brief 停止定时器并等待正在执行的回调结束，返回后回调不会再执行
+    /// @return 在自身回调内调用时只停止不等待，返回 -1
+    int stop_and_wait() { return Manager::instance().stop_and_wait(handler_); }
 
     /// @brief 设置周期任务间隔
     /// @param ms
     /// @return
-    int set_interval(unsigned ms) { return TimerManager::instance().set_interval(handler_, ms); }
+    int set_interval(unsigned ms) { return Manager::instance().set_interval(handler_, ms); }
 
     /// @brief 获取当前周期任务间隔
     /// @return
     unsigned interval() const { return handler_->interval_ns / 1000 / 1000; }
 
+    /// @brief 设置单次回调允许的最长执行时间，超过后由看门狗上报
+    /// @param ms 为0时使用看门狗的默认值
+    void set_budget(unsigned ms) { handler_->budget_ns = 1000ull * 1000 * ms; }
+
+    /// @brief 加入定时器组，之后可以随组一起停止和恢复
+    int join(BasicTimerGroup<Manager> &group) {
+        return Manager::instance().join_group(handler_, group.handler());
+    }
+
     void dump() { handler_->dump(); }
 
    private:
     TimerHandler handler_;
 };
 
+/// @brief 定时器组，组内定时器可以一起停止和恢复
+///
+/// 停止只翻转组 epoch，组内定时器到期时才被检查线程挂起；
+/// 恢复时在一次加锁内把停止前处于运行状态的定时器重新启动。
+template <typename Manager>
+class BasicTimerGroup {
+   public:
+    BasicTimerGroup() : group_(std::make_shared<TimerGroupState>()) {}
+
+    /// @brief 停止组内所有定时器，O(1)
+    int stop() { return Manager::instance().stop_group(group_); }
+
+    /// @brief 恢复组内定时器，单独停止的定时器不会被恢复
+    int start() { return Manager::instance().start_group(group_); }
+
+    bool stopped() const { return group_->stopped(); }
+
+    const TimerGroupHandler &handler() const { return group_; }
+
+   private:
+    TimerGroupHandler group_;
+};
+
+using Timer = BasicTimer<TimerManager>;
+using TimerGroup = BasicTimerGroup<TimerManager>;
+
 }  // namespace stroll
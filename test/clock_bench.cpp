@@ -0,0 +1,47 @@
+/**
+ * @file clock_bench.cpp
+ * @author stroll (116356647@qq.com)
+ * @brief 时钟源读取耗时对比
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <cinttypes>
+#include <cstdio>
+
+#include "utils/clock.hpp"
+
+using namespace stroll;
+
+static const unsigned kLoops = 10 * 1000 * 1000;
+
+template <typename Func>
+void bench(const char *name, Func &&func) {
+    uint64_t sum = 0;
+    auto begin = SteadyClock::read();
+    for (auto i = 0u; i < kLoops; ++i) {
+        sum += func();
+    }
+    auto cost = SteadyClock::read() - begin;
+    printf("%-24s %6.2f ns/read (checksum %" PRIu64 ")\n", name, (double)cost / kLoops, sum & 0xff);
+}
+
+int main() {
+    ClockSource &steady = SteadyClock::instance();
+    ClockSource &tsc = TscClock::instance();
+    ClockSource &coarse = CoarseClock::instance();
+
+    printf("invariant tsc: %s\n", TscClock::instance().enabled() ? "yes" : "no");
+    bench("steady_clock::now", []() { return SteadyClock::read(); });
+    bench("SteadyClock (virtual)", [&]() { return steady.now_ns(); });
+    bench("TscClock (virtual)", [&]() { return tsc.now_ns(); });
+    bench("CoarseClock (virtual)", [&]() { return coarse.now_ns(); });
+
+    //< 对比两个时钟的偏差
+    auto diff = (int64_t)(tsc.now_ns() - steady.now_ns());
+    printf("tsc - steady: %" PRId64 " ns\n", diff);
+    return 0;
+}
@@ -0,0 +1,89 @@
+/**
+ * @file dispatch_bench.cpp
+ * @author stroll (116356647@qq.com)
+ * @brief 线程池轮转检查与专用检查线程两种模式的线程切换和触发延迟对比
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#include "utils/timer.hpp"
+
+using namespace stroll;
+
+static const unsigned kTimerNum = 16;
+static const unsigned kIntervalMs = 10;
+static const unsigned kRunMs = 2000;
+
+static uint64_t context_switches() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+/// @brief kTimerNum 个周期任务运行 kRunMs，延迟为回调开始执行时间与最近一个理论到期时间之差
+///
+/// 延迟超过一个周期的触发会被折算，周期取得比预期延迟大得多
+template <typename Manager>
+void bench(const char *name) {
+    std::mutex mtx;
+    std::vector<uint64_t> latencies;
+    latencies.reserve(kTimerNum * kRunMs / kIntervalMs * 2);
+
+    std::vector<std::unique_ptr<BasicTimer<Manager>>> timers;
+    std::vector<uint64_t> first_tp(kTimerNum);
+    for (auto i = 0u; i < kTimerNum; ++i) {
+        timers.emplace_back(new BasicTimer<Manager>(
+            name,
+            [&, i]() {
+                auto now = SteadyClock::read();
+                auto elapsed = now > first_tp[i] ? now - first_tp[i] : 0;
+                auto latency = elapsed % (kIntervalMs * 1000 * 1000);
+                std::lock_guard guard(mtx);
+                latencies.push_back(latency);
+            },
+            kIntervalMs, kIntervalMs));
+    }
+
+    //< 先让线程就绪，避免把创建线程的切换算进去
+    Manager::instance();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    auto switches = context_switches();
+    for (auto i = 0u; i < kTimerNum; ++i) {
+        first_tp[i] = SteadyClock::read() + kIntervalMs * 1000 * 1000;
+        timers[i]->start();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(kRunMs));
+    for (auto &timer : timers) {
+        timer->stop_and_wait();
+    }
+    switches = context_switches() - switches;
+
+    std::sort(latencies.begin(), latencies.end());
+    uint64_t sum = 0;
+    for (auto latency : latencies) {
+        sum += latency;
+    }
+    auto count = std::max<size_t>(1, latencies.size());
+    printf("%-10s firings: %6zu  ctx switches/firing: %5.2f  latency avg: %7.1f us  p50: %7.1f us  "
+           "p99: %7.1f us\n",
+           name, latencies.size(), (double)switches / count, (double)sum / count / 1000,
+           latencies[count / 2] / 1000.0, latencies[count * 99 / 100] / 1000.0);
+}
+
+int main() {
+    bench<TimerManager>("pool");
+    bench<BasicTimerManager<TimerHeap, ClockSource, std::mutex, DispatchExecutor<4>>>("dispatch");
+    return 0;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file flight_recorder.cpp
+ * @author stroll (116356647@qq.com)
+ * @brief 飞行记录器崩溃转储演示，带参数 crash 运行时触发段错误
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <unistd.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "utils/logger.hpp"
+
+using namespace stroll;
+
+static const char *kDumpPath = "/tmp/stroll_flight_recorder.txt";
+
+int main(int argc, char **argv) {
+    //< 生产环境只输出 Warn，飞行记录器默认记录全部级别，Debug 和 Info 只进入飞行记录器
+    set_log_level(kWarn);
+    FlightRecorder::install_crash_handler(kDumpPath);
+
+    std::vector<std::thread> threads;
+    for (auto t = 0u; t < 3; ++t) {
+        threads.emplace_back([t]() {
+            for (auto i = 0u; i < 100; ++i) {
+                sl_debug("worker %u step %u ratio %f\n", t, i, i / 3.0);
+            }
+            sl_info("worker %u %s\n", t, "finished");
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    sl_record("event %d without output, ptr %p, hex %x, char %c\n", -42, (void *)&threads, 255, 'z');
+    sl_warn("about to %s\n", argc > 1 ? argv[1] : "dump");
+
+    if (argc > 1 && strcmp(argv[1], "crash") == 0) {
+        //< 崩溃时由信号处理函数写出 kDumpPath
+        volatile int *null = nullptr;
+        *null = 1;
+    }
+    FlightRecorder::dump(STDOUT_FILENO);
+    return 0;
+}
@@ -0,0 +1,342 @@
+/**
+ * @file logger.cpp
+ * @author stroll (116356647@qq.com)
+ * @brief 日志同步、异步和延迟格式化输出对比
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <sys/stat.h>
+#include <time.h>
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cinttypes>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils/logger.hpp"
+
+using namespace stroll;
+
+static const unsigned kThreadNum = 4;
+static const unsigned kLines = 20000;
+
+static uint64_t thread_cpu_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000ull * 1000 * 1000 + ts.tv_nsec;
+}
+
+/// @brief printf 风格的 TRACE_INFO
+static void log_printf(unsigned t, unsigned i) {
+    sl_info("thread %u line %u value %f\n", t, i, i * 0.5);
+}
+
+/// @brief 同样内容的 fmt 风格 TRACE_FMT
+static void log_fmt(unsigned t, unsigned i) {
+    slf_info("thread {} line {} value {:f}\n", t, i, i * 0.5);
+}
+
+/// @brief kThreadNum 个线程各写 kLines 行，返回调用线程上的平均 CPU 耗时
+template <typename Log>
+double bench_calls(Log &&log) {
+    std::vector<std::thread> threads;
+    std::vector<uint64_t> costs(kThreadNum);
+    for (auto t = 0u; t < kThreadNum; ++t) {
+        threads.emplace_back([t, &costs, &log]() {
+            auto begin = thread_cpu_ns();
+            for (auto i = 0u; i < kLines; ++i) {
+                log(t, i);
+            }
+            costs[t] = thread_cpu_ns() - begin;
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    uint64_t sum = 0;
+    for (auto cost : costs) {
+        sum += cost;
+    }
+    return (double)sum / kThreadNum / kLines;
+}
+
+/// @brief kThreadNum 个线程并发生成时间前缀，返回调用线程上的平均 CPU 耗时
+template <typename Func>
+double bench_threads(Func &&func) {
+    std::vector<std::thread> threads;
+    std::vector<uint64_t> costs(kThreadNum);
+    for (auto t = 0u; t < kThreadNum; ++t) {
+        threads.emplace_back([t, &costs, &func]() {
+            auto begin = thread_cpu_ns();
+            for (auto i = 0u; i < kLines * 10; ++i) {
+                func();
+            }
+            costs[t] = thread_cpu_ns() - begin;
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    uint64_t sum = 0;
+    for (auto cost : costs) {
+        sum += cost;
+    }
+    return (double)sum / kThreadNum / kLines / 10;
+}
+
+/// @brief 时间前缀：每行 localtime_r + printf 与按秒缓存、原始时间戳对比
+void bench_time_text() {
+    static thread_local char text[64];
+    auto legacy_ns = bench_threads([]() {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        struct tm datetime;
+        localtime_r(&ts.tv_sec, &datetime);
+        snprintf(text, sizeof(text), "%04d-%02d-%02d %02d:%02d:%02d.%03d", datetime.tm_year + 1900,
+                 datetime.tm_mon + 1, datetime.tm_mday, datetime.tm_hour, datetime.tm_min,
+                 datetime.tm_sec, (int)(ts.tv_nsec / 1000 / 1000));
+    });
+    auto cached_ns = bench_threads([]() { log_time_text(log_now_ns(false), false); });
+    auto raw_ns = bench_threads([]() { log_time_text(log_now_ns(true), true); });
+    fprintf(stderr, "time prefix: localtime_r %.1f ns, cached %.1f ns, raw %.1f ns\n", legacy_ns,
+            cached_ns, raw_ns);
+}
+
+/// @brief 只比较消息正文的格式化：vsnprintf 与编译期解析的格式串
+void bench_body() {
+    static const unsigned kRounds = kLines * 10;
+    static constexpr auto kSpec = LogFmtSpec::parse("thread {} line {} value {:f}\n");
+    char text[128];
+    size_t total = 0;
+
+    auto begin = thread_cpu_ns();
+    for (auto i = 0u; i < kRounds; ++i) {
+        total += snprintf(text, sizeof(text), "thread %u line %u value %f\n", 3u, i, i * 0.5);
+    }
+    auto printf_ns = (double)(thread_cpu_ns() - begin) / kRounds;
+
+    begin = thread_cpu_ns();
+    for (auto i = 0u; i < kRounds; ++i) {
+        LogFmtBuffer out(text, sizeof(text));
+        log_fmt_write(out, kSpec, "thread {} line {} value {:f}\n", 3u, i, i * 0.5);
+        total += out.size();
+    }
+    auto fmt_ns = (double)(thread_cpu_ns() - begin) / kRounds;
+    fprintf(stderr, "message body: snprintf %.1f ns, compile-time format %.1f ns (%zu bytes)\n",
+            printf_ns, fmt_ns, total);
+}
+
+/// @brief 被运行时级别过滤的日志只付出一次 relaxed 读，参数不会求值
+double bench_filtered() {
+    set_log_level(kWarn);
+    follow_record_level();
+    unsigned evaluated = 0;
+    auto begin = thread_cpu_ns();
+    for (auto i = 0u; i < kLines * 100; ++i) {
+        sl_debug("value %u\n", ++evaluated);
+    }
+    auto cost = thread_cpu_ns() - begin;
+    set_log_level(kDebug);
+    reset_record_level();
+    fprintf(stderr, "filtered debug: evaluated %u times\n", evaluated);
+    return (double)cost / kLines / 100;
+}
+
+/// @brief 输出级别为 Warn 时 debug 日志只写入飞行记录器
+double bench_recorded() {
+    set_log_level(kWarn);
+    auto begin = thread_cpu_ns();
+    for (auto i = 0u; i < kLines * 10; ++i) {
+        sl_debug("value %u name %s ratio %f\n", i, "recorded", i * 0.5);
+    }
+    auto cost = thread_cpu_ns() - begin;
+    set_log_level(kDebug);
+    return (double)cost / kLines / 10;
+}
+
+/// @brief 限流日志：kThreadNum 个线程在同一调用处高频告警，每 100ms 只输出一行
+double bench_limited() {
+    std::vector<std::thread> threads;
+    std::vector<uint64_t> costs(kThreadNum);
+    for (auto t = 0u; t < kThreadNum; ++t) {
+        threads.emplace_back([t, &costs]() {
+            auto begin = thread_cpu_ns();
+            for (auto i = 0u; i < kLines * 10; ++i) {
+                sl_warn_every_ms(100, "thread %u overrun %u\n", t, i);
+            }
+            costs[t] = thread_cpu_ns() - begin;
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (auto i = 0u; i < 10; ++i) {
+        sl_warn_every_n(4, "every 4th: %u\n", i);
+        sl_warn_sampled(4, "sampled 1/4: %u\n", i);
+    }
+
+    uint64_t sum = 0;
+    for (auto cost : costs) {
+        sum += cost;
+    }
+    return (double)sum / kThreadNum / kLines / 10;
+}
+
+/// @brief 延迟模式单线程的调用代价，record_level 为 kError 时不写飞行记录器
+///
+/// 每批的写入量小于线程缓冲区，批之间留时间给后台线程读完，统计的都是真正写入的记录，
+/// 不会因为缓冲区满直接丢弃而显得更快。
+double bench_deferred(LogLevel record_level) {
+    static const unsigned kBatch = 2000;
+    set_record_level(record_level);
+    DeferredLogger::instance().start();
+    uint64_t cost = 0;
+    for (auto round = 0u; round < kLines / kBatch; ++round) {
+        auto begin = thread_cpu_ns();
+        for (auto i = 0u; i < kBatch; ++i) {
+            log_printf(0, i);
+        }
+        cost += thread_cpu_ns() - begin;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    DeferredLogger::instance().stop();
+    reset_record_level();
+    return (double)cost / (kLines / kBatch * kBatch);
+}
+
+/// @brief 同步输出到文件，每个文件 2MB 轮转，返回调用线程上的平均 CPU 耗时
+double bench_file() {
+    static const char *kPath = "/tmp/stroll_logger.log";
+    LogFileOptions options;
+    options.path = kPath;
+    options.max_size = 2 * 1024 * 1024;
+    options.max_files = 3;
+    if (!log_to_file(options)) {
+        fprintf(stderr, "open %s failed\n", kPath);
+        return 0;
+    }
+    auto cost = bench_calls(log_printf);
+    log_to_stdout();
+
+    auto files = 0u;
+    struct stat st;
+    for (auto i = 0u; i <= options.max_files; ++i) {
+        auto path = i == 0 ? std::string(kPath) : kPath + ("." + std::to_string(i));
+        if (stat(path.c_str(), &st) == 0) {
+            ++files;
+        }
+    }
+    fprintf(stderr, "file sink: %u files kept for %s\n", files, kPath);
+    return cost;
+}
+
+/// @brief 后台线程写出吞吐：同一批格式化好的日志行分别写入文件缓冲区和内存映射文件
+void bench_sink_write() {
+    static const unsigned kRecords = 1000 * 1000;
+    char line[128];
+    auto len = snprintf(line, sizeof(line),
+                        "[2026-10-16 12:00:00.000][tag][Info][logger.cpp:bench:1] "
+                        "a preformatted record of about one hundred bytes\n");
+
+    auto run = [&](LogSink &sink) {
+        auto begin = std::chrono::steady_clock::now();
+        for (auto i = 0u; i < kRecords; ++i) {
+            sink.write(line, len);
+        }
+        sink.close();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin)
+                   .count() /
+               kRecords;
+    };
+
+    //< 文件输出积压超过上限时直接丢弃，丢弃的记录不计入吞吐
+    LogFileOptions file_options;
+    file_options.path = "/tmp/stroll_sink_file.log";
+    unlink(file_options.path.c_str());
+    LogFileSink::instance().open(file_options);
+    auto dropped = LogFileSink::instance().dropped();
+    auto file_ns = run(LogFileSink::instance());
+    dropped = LogFileSink::instance().dropped() - dropped;
+    file_ns = file_ns * kRecords / std::max<uint64_t>(kRecords - dropped, 1);
+
+    LogMmapOptions mmap_options;
+    mmap_options.path = "/tmp/stroll_sink_mmap.log";
+    unlink(mmap_options.path.c_str());
+    LogMmapSink::instance().open(mmap_options);
+    auto mmap_ns = run(LogMmapSink::instance());
+
+    struct stat file_st, mmap_st;
+    stat(file_options.path.c_str(), &file_st);
+    stat(mmap_options.path.c_str(), &mmap_st);
+    fprintf(stderr,
+            "sink write: file %.1f ns/record (%ld bytes, %" PRIu64
+            " dropped), mmap %.1f ns/record (%ld bytes)\n",
+            file_ns, (long)file_st.st_size, dropped, mmap_ns, (long)mmap_st.st_size);
+}
+
+/// @brief 超过 LogRecord::kMsgSize 的正文在异步模式下也完整输出
+void test_long_message() {
+    std::string text(500, 'x');
+    AsyncLogger::instance().start();
+    sl_info("long %s end\n", text.c_str());
+    slf_info("long fmt {} end\n", text);
+    AsyncLogger::instance().stop();
+}
+
+/// @brief 限流参数为0时不限流，不会除零
+void test_limit_zero() {
+    for (auto i = 0; i < 2; ++i) {
+        sl_warn_every_n(0, "every_n(0) %d\n", i);
+        sl_warn_every_ms(0, "every_ms(0) %d\n", i);
+        sl_warn_sampled(0, "sampled(0) %d\n", i);
+    }
+}
+
+int main() {
+    test_long_message();
+    test_limit_zero();
+    bench_time_text();
+    bench_body();
+    auto filtered_ns = bench_filtered();
+    auto recorded_ns = bench_recorded();
+    auto limited_ns = bench_limited();
+
+    double printf_ns[3], fmt_ns[3];
+    printf_ns[0] = bench_calls(log_printf);
+    fmt_ns[0] = bench_calls(log_fmt);
+    AsyncLogger::instance().start();
+    printf_ns[1] = bench_calls(log_printf);
+    fmt_ns[1] = bench_calls(log_fmt);
+    AsyncLogger::instance().stop();
+    DeferredLogger::instance().start();
+    printf_ns[2] = bench_calls(log_printf);
+    fmt_ns[2] = bench_calls(log_fmt);
+    DeferredLogger::instance().stop();
+    auto deferred_ns = bench_deferred(kError);
+    auto deferred_recorded_ns = bench_deferred(kDebug);
+    auto file_ns = bench_file();
+    bench_sink_write();
+
+    fprintf(stderr,
+            "filtered: %.1f ns/call, recorded only: %.1f ns/call, limited: %.1f ns/call, "
+            "sync to file: %.1f ns/call\n",
+            filtered_ns, recorded_ns, limited_ns, file_ns);
+    const char *modes[] = {"sync", "async", "deferred"};
+    for (auto i = 0u; i < 3; ++i) {
+        fprintf(stderr, "%-8s TRACE_INFO %.1f ns/call, TRACE_FMT %.1f ns/call\n", modes[i],
+                printf_ns[i], fmt_ns[i]);
+    }
+    fprintf(stderr,
+            "deferred single thread: %.1f ns/call without flight recorder, %.1f ns/call with it\n",
+            deferred_ns, deferred_recorded_ns);
+    return 0;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file rate_limiter.cpp
+ * @author stroll (116356647@qq.com)
+ * @brief rate limiter 测试程序
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "utils/rate_limiter.hpp"
+
+#include <thread>
+#include <vector>
+
+#include "utils/logger.hpp"
+
+using namespace stroll;
+
+void test_burst() {
+    VirtualClock clock;
+    TokenBucket bucket(10, 5, clock);
+
+    unsigned count = 0;
+    while (bucket.try_acquire()) {
+        ++count;
+    }
+    sl_info("burst: %u, wait: %" PRIu64 " ns\n", count, bucket.wait_time_ns());
+    sl_info("acquire on virtual clock: %d\n", bucket.acquire());
+
+    clock.advance(1000ull * 1000 * 1000);
+    sl_info("after 1s available: %u\n", bucket.available());
+}
+
+void test_tenants() {
+    static const unsigned kTenants = 100 * 1000;
+    std::vector<std::unique_ptr<TokenBucket>> buckets;
+    buckets.reserve(kTenants);
+    for (auto i = 0u; i < kTenants; ++i) {
+        buckets.emplace_back(std::make_unique<TokenBucket>(100, 10));
+    }
+
+    auto begin = SteadyClock::read();
+    unsigned passed = 0;
+    for (auto round = 0; round < 20; ++round) {
+        for (auto &bucket : buckets) {
+            passed += bucket->try_acquire();
+        }
+    }
+    auto cost = SteadyClock::read() - begin;
+    sl_info("tenants: %u, passed: %u, %.2f ns/try_acquire\n", kTenants, passed,
+            (double)cost / kTenants / 20);
+}
+
+void test_acquire() {
+    TokenBucket bucket(100, 1);
+    auto begin = SteadyClock::read();
+    for (auto i = 0; i < 50; ++i) {
+        bucket.acquire();
+    }
+    sl_info("acquire 50 tokens at 100/s cost %" PRIu64 " ms\n",
+            (SteadyClock::read() - begin) / 1000 / 1000);
+    sl_info("acquire 2 tokens with burst 1: %d\n", bucket.acquire(2));
+}
+
+void test_waiters() {
+    TokenBucket bucket(100, 1);
+    std::atomic<unsigned> count{0};
+    std::vector<std::thread> threads;
+    auto begin = SteadyClock::read();
+    for (auto i = 0; i < 8; ++i) {
+        threads.emplace_back([&]() {
+            for (auto j = 0; j < 5; ++j) {
+                bucket.acquire();
+                ++count;
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    sl_info("8 waiters acquire %u tokens at 100/s cost %" PRIu64 " ms\n", count.load(),
+            (SteadyClock::read() - begin) / 1000 / 1000);
+}
+
+int main() {
+    test_burst();
+    test_tenants();
+    test_acquire();
+    test_waiters();
+    return 0;
+}
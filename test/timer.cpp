@@ -10,8 +10,12 @@
  */
 
 #include "utils/timer.hpp"
+#include "utils/concurrent_timer_queue.hpp"
 #include "utils/logger.hpp"
 
+#include <random>
+#include <unordered_map>
+
 using namespace stroll;
 
 MinHeap heap;
@@ -106,8 +110,290 @@ void test_timer() {
     getchar();
 }
 
+void test_timer_loop() {
+    TimerLoop loop;
+    auto fast = loop.add_timer("fast", []() { sl_info("fast\n"); }, 100);
+    auto once = loop.add_timer("once", []() { sl_info("once\n"); }, 0, 250);
+
+    uint64_t now = 0;
+    loop.start(fast, now);
+    loop.start(once, now);
+    while (now <= 500 * 1000 * 1000ull) {
+        now = loop.next_deadline();
+        printf("now: %" PRIu64 " fired: %u\n", now, loop.poll(now));
+        if (now >= 300 * 1000 * 1000ull) {
+            loop.stop(fast);
+        }
+        if (loop.next_deadline() == TimerNode::kMaxTimePoint) {
+            break;
+        }
+    }
+}
+
+void test_virtual_clock() {
+    VirtualClock clock;
+    TimerLoop loop(clock);
+    uint64_t second_count = 0;
+    uint64_t minute_count = 0;
+    auto second = loop.add_timer("second", [&]() { ++second_count; }, 1000);
+    auto minute = loop.add_timer("minute", [&]() { ++minute_count; }, 60 * 1000, 500);
+    loop.start(second);
+    loop.start(minute);
+
+    //< 模拟 24h
+    auto fired = loop.run_until(clock, 24ull * 3600 * 1000 * 1000 * 1000);
+    sl_info("fired: %" PRIu64 ", second: %" PRIu64 ", minute: %" PRIu64 "\n", fired, second_count,
+            minute_count);
+}
+
+void test_timer_group() {
+    std::atomic<unsigned> count{0};
+    TimerGroup group;
+    std::vector<std::unique_ptr<Timer>> timers;
+    for (auto i = 0; i < 100; ++i) {
+        timers.emplace_back(std::make_unique<Timer>("group", [&count]() { ++count; }, 10));
+        timers.back()->join(group);
+        timers.back()->start();
+    }
+    timers[0]->stop();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(25));
+    //< 未停止的组 start 不会重新计时
+    group.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    group.stop();
+    sl_info("group running, count: %u\n", count.load());
+    std::this_thread::sleep_for(std::chrono::milliseconds(55));
+    sl_info("group stopped, count: %u\n", count.load());
+    group.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(55));
+    sl_info("group restarted, count: %u\n", count.load());
+    for (auto &timer : timers) {
+        timer->stop_and_wait();
+    }
+
+    //< 已销毁的定时器在下次加入时被清除
+    timers.resize(10);
+    Timer extra("group", []() {}, 10);
+    extra.join(group);
+    sl_info("group members after prune: %zu\n", group.handler()->members.size());
+}
+
+void test_watchdog() {
+    WatchdogOptions options;
+    options.period_ms = 50;
+    options.replace_stalled = true;
+    TimerManager::instance().enable_watchdog(options);
+
+    std::atomic<bool> hang{true};
+    Timer stalled("stalled", [&hang]() {
+        while (hang) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }, 0);
+    stalled.set_budget(100);
+    stalled.start();
+
+    std::atomic<unsigned> count{0};
+    Timer normal("normal", [&count]() { ++count; }, 20);
+    normal.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    hang = false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    sl_info("normal count: %u\n", count.load());
+}
+
+void test_stop_and_wait() {
+    std::atomic<bool> in_callback{false};
+    std::atomic<unsigned> count{0};
+    Timer slow("slow", [&]() {
+        in_callback = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ++count;
+        in_callback = false;
+    }, 10);
+    slow.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    slow.stop_and_wait();
+    auto stopped = count.load();
+    sl_info("in callback after stop_and_wait: %d\n", in_callback.load());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    sl_info("count: %u -> %u\n", stopped, count.load());
+
+    Timer *self = nullptr;
+    int ret = 0;
+    Timer self_stop("self stop", [&]() { ret = self->stop_and_wait(); }, 10);
+    self = &self_stop;
+    self_stop.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    sl_info("self stop return: %d\n", ret);
+}
+
+void test_next_delay() {
+    auto begin = SteadyClock::read();
+    int64_t delay = 10;
+    Timer backoff("backoff", [&]() -> int64_t {
+        sl_info("elapsed %" PRIu64 " ms, next delay %" PRId64 " ms\n",
+                (SteadyClock::read() - begin) / 1000 / 1000, delay);
+        delay *= 2;
+        return delay > 200 ? kTimerStop : delay / 2;
+    });
+    backoff.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    std::atomic<unsigned> count{0};
+    Timer once("once", [&]() -> int64_t {
+        ++count;
+        return kTimerStop;
+    }, std::chrono::milliseconds(10));
+    once.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    sl_info("stopped by return value, count: %u\n", count.load());
+}
+
+void test_interval_lane() {
+    static const unsigned intervals[] = {10, 20, 50};
+    std::atomic<unsigned> counts[3] = {};
+    std::vector<std::unique_ptr<Timer>> timers;
+    for (auto i = 0; i < 300; ++i) {
+        auto &count = counts[i % 3];
+        timers.emplace_back(
+            std::make_unique<Timer>("lane", [&count]() { ++count; }, intervals[i % 3], i % 7));
+        timers.back()->start();
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(205));
+    for (auto &timer : timers) {
+        timer->stop_and_wait();
+    }
+    sl_info("10ms: %u, 20ms: %u, 50ms: %u\n", counts[0].load(), counts[1].load(),
+            counts[2].load());
+}
+
+void test_basic_manager() {
+    using FastManager = BasicTimerManager<PairingHeap, SteadyClock, SpinLock, PoolExecutor<2>,
+                                          CounterStats>;
+    std::atomic<int> count{0};
+    BasicTimer<FastManager> tick("fast_tick", [&]() { ++count; }, 10);
+    tick.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    tick.stop_and_wait();
+    sl_info("fast_tick count: %d\n", count.load());
+    FastManager::instance().stats().dump();
+}
+
+void test_concurrent_queue() {
+    static const unsigned kThreads = 4;
+    static const unsigned kTimers = 1000;
+    ConcurrentTimerQueue queue;
+    std::vector<TimerHandler> timers;
+    std::unordered_map<TimerNode *, unsigned> index;
+    for (auto i = 0u; i < kTimers; ++i) {
+        timers.push_back(std::make_shared<TimerNode>());
+        index[timers.back().get()] = i;
+    }
+
+    //< 每个线程负责一段定时器，反复重启后取消其中的偶数号
+    std::vector<std::thread> producers;
+    for (auto t = 0u; t < kThreads; ++t) {
+        producers.emplace_back([&, t]() {
+            std::mt19937_64 rng(t);
+            for (auto round = 0; round < 100; ++round) {
+                for (auto i = t; i < kTimers; i += kThreads) {
+                    queue.insert(timers[i], rng() % 1000);
+                }
+            }
+            for (auto i = t; i < kTimers; i += kThreads) {
+                if (i % 2 == 0) {
+                    queue.cancel(timers[i]);
+                }
+            }
+        });
+    }
+    for (auto &producer : producers) {
+        producer.join();
+    }
+
+    //< 奇数号只应取出最后一次启动，偶数号不应取出
+    std::vector<unsigned> fired(kTimers);
+    uint64_t last_tp = 0;
+    uint64_t tp;
+    uint32_t gen;
+    bool ordered = true;
+    while (auto handler = queue.delete_min(1000, tp, gen)) {
+        ++fired[index[handler.get()]];
+        ordered = ordered && tp >= last_tp;
+        last_tp = tp;
+    }
+    unsigned wrong = 0;
+    for (auto i = 0u; i < kTimers; ++i) {
+        wrong += fired[i] != i % 2;
+    }
+
+    //< 没有生产者访问时，epoch 推进两次后摘除的条目全部释放
+    auto retired = queue.retired();
+    for (auto i = 0; i < 3; ++i) {
+        queue.delete_min(0);
+    }
+    sl_info("concurrent queue wrong: %u, ordered: %d, retired: %zu -> %zu\n", wrong, ordered,
+            retired, queue.retired());
+
+    //< 作为 TimerManager 的堆，多个线程不加堆锁并发启停
+    using QueueManager = BasicTimerManager<ConcurrentTimerQueue, SteadyClock, std::mutex,
+                                           PoolExecutor<2>, CounterStats>;
+    std::atomic<unsigned> count{0};
+    std::vector<std::unique_ptr<BasicTimer<QueueManager>>> queue_timers;
+    for (auto i = 0; i < 64; ++i) {
+        queue_timers.emplace_back(
+            std::make_unique<BasicTimer<QueueManager>>("queue", [&count]() { ++count; }, 5));
+    }
+    producers.clear();
+    for (auto t = 0u; t < kThreads; ++t) {
+        producers.emplace_back([&, t]() {
+            std::mt19937_64 rng(t);
+            for (auto i = 0; i < 2000; ++i) {
+                auto &timer = queue_timers[rng() % queue_timers.size()];
+                switch (rng() % 3) {
+                    case 0:
+                        timer->start();
+                        break;
+                    case 1:
+                        timer->stop();
+                        break;
+                    default:
+                        timer->set_interval(5 + rng() % 5);
+                        break;
+                }
+            }
+        });
+    }
+    for (auto &producer : producers) {
+        producer.join();
+    }
+    for (auto &timer : queue_timers) {
+        timer->start();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    for (auto &timer : queue_timers) {
+        timer->stop_and_wait();
+    }
+    auto stopped = count.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    sl_info("concurrent manager count: %u, after stop: %u\n", stopped, count.load());
+    QueueManager::instance().stats().dump();
+}
+
 int main() {
     test_timer();
+    test_timer_loop();
+    test_virtual_clock();
+    test_timer_group();
+    test_watchdog();
+    test_stop_and_wait();
+    test_next_delay();
+    test_interval_lane();
+    test_basic_manager();
+    test_concurrent_queue();
 
     return 0;
 }
@@ -0,0 +1,202 @@
+/**
+ * @file timer_bench.cpp
+ * @author stroll (116356647@qq.com)
+ * @brief 定时器堆实现性能对比
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "utils/concurrent_timer_queue.hpp"
+#include "utils/timer.hpp"
+
+using namespace stroll;
+
+static const uint64_t kMs = 1000ull * 1000;
+
+/// @brief 模拟线上负载：周期 100ms/1s/10s 的定时器按时触发，穿插重启和停止
+template <typename Heap>
+void bench_mix(const char *name, unsigned timer_num, unsigned ops) {
+    static const uint64_t intervals[] = {100 * kMs, 1000 * kMs, 10 * 1000 * kMs};
+    std::mt19937_64 rng(42);
+    Heap heap;
+    std::vector<TimerHandler> timers;
+    for (auto i = 0u; i < timer_num; ++i) {
+        auto node = std::make_shared<TimerNode>();
+        node->interval_ns = intervals[rng() % 3];
+        heap.push(node);
+        heap.update_place(node, rng() % node->interval_ns);
+        timers.push_back(node);
+    }
+
+    uint64_t now = 0;
+    auto begin = SteadyClock::read();
+    for (auto i = 0u; i < ops; ++i) {
+        auto &top = heap.top();
+        now = std::max(now, top->next_tp);
+        heap.update_top(top->next_tp + top->interval_ns);
+
+        //< 约 1/4 的操作是重启或停止某个定时器
+        auto r = rng();
+        if ((r & 3) == 0) {
+            auto &node = timers[(r >> 8) % timer_num];
+            if (node->next_tp == TimerNode::kMaxTimePoint || (r & 16)) {
+                heap.update_place(node, now + node->interval_ns);
+            } else {
+                heap.update_place(node, TimerNode::kMaxTimePoint);
+            }
+        }
+    }
+    auto cost = SteadyClock::read() - begin;
+    printf("%-12s timers: %7u  %7.1f ns/op\n", name, timer_num, (double)cost / ops);
+}
+
+/// @brief 到期时间频繁提前的负载：3/4 的操作把某个定时器的到期时间提前，其余为堆顶到期
+template <typename Heap>
+void bench_tighten(const char *name, unsigned timer_num, unsigned ops) {
+    static const uint64_t kHorizon = 10 * 1000 * kMs;
+    std::mt19937_64 rng(42);
+    Heap heap;
+    std::vector<TimerHandler> timers;
+    for (auto i = 0u; i < timer_num; ++i) {
+        auto node = std::make_shared<TimerNode>();
+        heap.push(node);
+        heap.update_place(node, rng() % kHorizon);
+        timers.push_back(node);
+    }
+
+    uint64_t now = 0;
+    auto begin = SteadyClock::read();
+    for (auto i = 0u; i < ops; ++i) {
+        auto r = rng();
+        if ((r & 3) == 0) {
+            auto &top = heap.top();
+            now = std::max(now, top->next_tp);
+            heap.update_top(now + kHorizon);
+        } else {
+            auto &node = timers[(r >> 8) % timer_num];
+            auto left = node->next_tp > now ? node->next_tp - now : 0;
+            heap.update_place(node, now + left / 2);
+        }
+    }
+    auto cost = SteadyClock::read() - begin;
+    printf("%-12s timers: %7u  %7.1f ns/op (decrease-key)\n", name, timer_num, (double)cost / ops);
+}
+
+/// @brief 加锁的 MinHeap，作为并发启动的对照
+struct LockedMinHeap {
+    void add(const TimerHandler &node) {
+        std::lock_guard guard(mtx);
+        heap.push(node);
+    }
+
+    void insert(const TimerHandler &node, uint64_t tp) {
+        std::lock_guard guard(mtx);
+        heap.update_place(node, tp);
+    }
+
+    unsigned drain(uint64_t now) {
+        std::lock_guard guard(mtx);
+        unsigned count = 0;
+        while (!heap.empty() && heap.top()->next_tp <= now) {
+            heap.update_top(TimerNode::kMaxTimePoint);
+            ++count;
+        }
+        return count;
+    }
+
+    std::mutex mtx;
+    MinHeap heap;
+};
+
+/// @brief 无锁跳表队列
+struct SkipListQueue {
+    void add(const TimerHandler &) {}
+
+    void insert(const TimerHandler &node, uint64_t tp) { queue.insert(node, tp); }
+
+    unsigned drain(uint64_t now) {
+        unsigned count = 0;
+        while (queue.delete_min(now)) {
+            ++count;
+        }
+        return count;
+    }
+
+    ConcurrentTimerQueue queue;
+};
+
+/// @brief 多个线程并发启动定时器，一个检查线程持续取出到期任务
+/// @return 启动吞吐，单位为 Mops/s
+template <typename Queue>
+double bench_arm(unsigned thread_num, unsigned ops) {
+    static const unsigned kTimersPerThread = 1000;
+    Queue queue;
+    std::vector<std::vector<TimerHandler>> timers(thread_num);
+    for (auto &list : timers) {
+        for (auto i = 0u; i < kTimersPerThread; ++i) {
+            list.push_back(std::make_shared<TimerNode>());
+            queue.add(list.back());
+        }
+    }
+
+    std::atomic<bool> done{false};
+    std::thread checker([&]() {
+        while (!done.load(std::memory_order_relaxed)) {
+            if (queue.drain(SteadyClock::read()) == 0) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    auto begin = SteadyClock::read();
+    std::vector<std::thread> producers;
+    for (auto t = 0u; t < thread_num; ++t) {
+        producers.emplace_back([&, t]() {
+            std::mt19937_64 rng(t);
+            auto &list = timers[t];
+            for (auto i = 0u; i < ops / thread_num; ++i) {
+                queue.insert(list[i % kTimersPerThread], SteadyClock::read() + rng() % kMs);
+            }
+        });
+    }
+    for (auto &producer : producers) {
+        producer.join();
+    }
+    auto cost = SteadyClock::read() - begin;
+    done = true;
+    checker.join();
+    return (double)(ops / thread_num * thread_num) * 1000 / cost;
+}
+
+int main() {
+    for (auto num : {100u, 10000u, 1000000u}) {
+        bench_mix<MinHeap>("MinHeap", num, 2000000);
+        bench_mix<RadixHeap>("RadixHeap", num, 2000000);
+        bench_mix<PairingHeap>("PairingHeap", num, 2000000);
+    }
+    for (auto num : {100u, 10000u, 1000000u}) {
+        bench_tighten<MinHeap>("MinHeap", num, 2000000);
+        bench_tighten<RadixHeap>("RadixHeap", num, 2000000);
+        bench_tighten<PairingHeap>("PairingHeap", num, 2000000);
+    }
+
+    printf("\nthreads,locked_minheap_mops,skiplist_mops\n");
+    for (auto threads : {1u, 2u, 4u, 8u, 16u, 32u, 64u}) {
+        auto locked = bench_arm<LockedMinHeap>(threads, 1000000);
+        auto skiplist = bench_arm<SkipListQueue>(threads, 1000000);
+        printf("%u,%.2f,%.2f\n", threads, locked, skiplist);
+    }
+
+    return 0;
+}